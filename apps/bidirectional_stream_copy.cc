@@ -30,7 +30,8 @@ void bidirectional_stream_copy(Socket &socket) {
         _input,
         Direction::In,
         [&] {
-            _outbound.write(_input.read(_outbound.remaining_capacity()));
+            const auto spans = _outbound.writable_spans();
+            _outbound.commit_write(_input.read(spans.data(), spans.size()));
             if (_input.eof()) {
                 _outbound.end_input();
             }
@@ -42,9 +43,10 @@ void bidirectional_stream_copy(Socket &socket) {
     _eventloop.add_rule(socket,
                         Direction::Out,
                         [&] {
-                            const size_t bytes_to_write = min(max_copy_length, _outbound.buffer_size());
-                            const size_t bytes_written = socket.write(_outbound.peek_output(bytes_to_write), false);
-                            _outbound.pop_output(bytes_written);
+                            const auto views = _outbound.peek_view(max_copy_length);
+                            const size_t bytes_written =
+                                socket.write(BufferViewList(views.begin(), views.end()), false);
+                            _outbound.commit_read(bytes_written);
                             if (_outbound.eof()) {
                                 socket.shutdown(SHUT_WR);
                                 _outbound_shutdown = true;
@@ -58,7 +60,8 @@ void bidirectional_stream_copy(Socket &socket) {
         socket,
         Direction::In,
         [&] {
-            _inbound.write(socket.read(_inbound.remaining_capacity()));
+            const auto spans = _inbound.writable_spans();
+            _inbound.commit_write(socket.read(spans.data(), spans.size()));
             if (socket.eof()) {
                 _inbound.end_input();
             }
@@ -70,9 +73,10 @@ void bidirectional_stream_copy(Socket &socket) {
     _eventloop.add_rule(_output,
                         Direction::Out,
                         [&] {
-                            const size_t bytes_to_write = min(max_copy_length, _inbound.buffer_size());
-                            const size_t bytes_written = _output.write(_inbound.peek_output(bytes_to_write), false);
-                            _inbound.pop_output(bytes_written);
+                            const auto views = _inbound.peek_view(max_copy_length);
+                            const size_t bytes_written =
+                                _output.write(BufferViewList(views.begin(), views.end()), false);
+                            _inbound.commit_read(bytes_written);
 
                             if (_inbound.eof()) {
                                 _output.close();
@@ -0,0 +1,260 @@
+#include "lossy_fd_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+//! What happened on an EmulatedLink
+struct LinkStats {
+    size_t drops{0};         //!< segments dropped because the queue was full
+    uint64_t sent{0};        //!< segments that made it onto the link
+    uint64_t queue_time{0};  //!< the sum of the time those segments waited in the queue
+
+    //! \returns the average time, in milliseconds, a segment waited in the queue
+    double queueing_delay() const { return sent ? double(queue_time) / double(sent) : 0; }
+};
+
+//! \brief A one-way bottleneck link, simulated in memory, with the interface LossyFdAdapter expects
+
+//! Segments written to the link wait in a drop-tail queue, leave it at the link's rate, and come out
+//! of read() after the propagation delay. Time only passes through tick().
+class EmulatedLink {
+    FdAdapterConfig _cfg{};
+    size_t _rate;         //!< bytes per millisecond
+    uint64_t _delay;      //!< one-way propagation delay, in milliseconds
+    size_t _queue_limit;  //!< bytes the queue holds before it drops
+    deque<pair<uint64_t, TCPSegment>> _queue{};  //!< segments waiting for the link, with their arrival times
+    size_t _queued{0};
+    deque<pair<uint64_t, TCPSegment>> _propagating{};
+    uint64_t _now{0};
+    size_t _credit{0};
+    LinkStats &_stats;
+
+    //! the bytes a segment occupies on the wire, counting IPv4 and TCP headers
+    static size_t wire_size(const TCPSegment &seg) { return seg.payload().size() + 40; }
+
+  public:
+    EmulatedLink(const size_t rate, const uint64_t delay, const size_t queue_limit, LinkStats &stats)
+        : _rate(rate), _delay(delay), _queue_limit(queue_limit), _stats(stats) {}
+
+    void write(TCPSegment &seg) {
+        if (_queued + wire_size(seg) > _queue_limit) {
+            ++_stats.drops;
+            return;
+        }
+        _queued += wire_size(seg);
+        _queue.emplace_back(_now, move(seg));
+    }
+
+    optional<TCPSegment> read() {
+        if (_propagating.empty() or _propagating.front().first > _now) {
+            return {};
+        }
+        auto seg = move(_propagating.front().second);
+        _propagating.pop_front();
+        return seg;
+    }
+
+    void tick(const size_t ms_since_last_tick) {
+        for (size_t i = 0; i < ms_since_last_tick; ++i) {
+            ++_now;
+            _credit += _rate;
+            while (not _queue.empty() and _credit >= wire_size(_queue.front().second)) {
+                auto &[arrival, seg] = _queue.front();
+                _credit -= wire_size(seg);
+                _queued -= wire_size(seg);
+                ++_stats.sent;
+                _stats.queue_time += _now - arrival;
+                _propagating.emplace_back(_now + _delay, move(seg));
+                _queue.pop_front();
+            }
+            if (_queue.empty()) {
+                // an idle link doesn't save up capacity
+                _credit = min(_credit, _rate);
+            }
+        }
+    }
+
+    void set_listening(const bool) {}
+    const FdAdapterConfig &config() const { return _cfg; }
+    FdAdapterConfig &config_mut() { return _cfg; }
+};
+
+// a 5 Mbit/s bottleneck with a 40 ms round trip: the path holds 25 kB plus 16 kB of queue,
+// while the receiver's window alone would let the sender put 64 kB in flight
+constexpr size_t link_rate = 625;
+constexpr uint64_t link_delay = 20;
+constexpr size_t queue_limit = 16'000;
+constexpr uint64_t duration_ms = 60'000;
+
+// a queue ten times deeper than the path, which a loss-driven algorithm fills before it backs off
+constexpr size_t deep_queue_limit = 250'000;
+constexpr size_t deep_window = 1024 * 1024;
+
+const char *algorithm_name(const CongestionAlgorithm algorithm) {
+    switch (algorithm) {
+        case CongestionAlgorithm::NewReno:
+            return "NewReno";
+        case CongestionAlgorithm::Cubic:
+            return "CUBIC";
+        case CongestionAlgorithm::Bbr:
+            return "BBR";
+        default:
+            return "none";
+    }
+}
+
+//! how the sender finds and repairs losses
+struct Recovery {
+    const char *name;
+    bool adaptive_rto;
+    bool fast_retransmit;
+    bool pacing;
+    bool sack;
+};
+
+//! the outcome of a bulk transfer over the emulated path
+struct Transfer {
+    double goodput;     //!< in Mbit/s
+    LinkStats uplink;   //!< what happened at the bottleneck
+    uint64_t timeouts;  //!< how often the sender's retransmission timer expired
+};
+
+Transfer transfer(const CongestionAlgorithm algorithm,
+                  const uint16_t loss_rate,
+                  const Recovery &recovery,
+                  const size_t queue_bytes = queue_limit,
+                  const size_t window = TCPConfig::DEFAULT_CAPACITY) {
+    TCPConfig config;
+    config.recv_capacity = window;
+    config.window_scaling = window > UINT16_MAX;
+    config.congestion_control = algorithm;
+    config.adaptive_rto = recovery.adaptive_rto;
+    config.fast_retransmit = recovery.fast_retransmit;
+    config.pacing = recovery.pacing;
+    config.sack = recovery.sack;
+    TCPConnection x{config}, y{config};
+
+    LinkStats uplink_stats, downlink_stats;
+    LossyFdAdapter<EmulatedLink> uplink{EmulatedLink{link_rate, link_delay, queue_bytes, uplink_stats}};
+    uplink.config_mut().loss_rate_up = loss_rate;
+    EmulatedLink downlink{link_rate, link_delay, queue_bytes, downlink_stats};
+
+    const string chunk(TCPConfig::DEFAULT_CAPACITY, 'x');
+    x.connect();
+    y.end_input_stream();
+
+    uint64_t received = 0;
+    const auto exchange = [&] {
+        while (not x.segments_out().empty()) {
+            uplink.write(x.segments_out().front());
+            x.segments_out().pop();
+        }
+        while (not y.segments_out().empty()) {
+            downlink.write(y.segments_out().front());
+            y.segments_out().pop();
+        }
+
+        uplink.tick(1);
+        downlink.tick(1);
+        while (auto seg = uplink.read()) {
+            y.segment_received(*seg);
+        }
+        while (auto seg = downlink.read()) {
+            x.segment_received(*seg);
+        }
+
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+        if (x.active()) {
+            x.tick(1);
+        }
+        if (y.active()) {
+            y.tick(1);
+        }
+    };
+
+    for (uint64_t now = 0; now < duration_ms and x.active(); ++now) {
+        x.write(chunk.substr(0, x.remaining_outbound_capacity()));
+        exchange();
+        received = y.inbound_stream().bytes_read();
+    }
+    if (not x.active()) {
+        cerr << "connection reset after too many retransmissions\n";
+    }
+
+    // wind both ends down so neither is torn down mid-transfer
+    x.end_input_stream();
+    while (x.active() or y.active()) {
+        exchange();
+    }
+    return {received * 8.0 / duration_ms / 1000, uplink_stats, x.sender().timeouts()};
+}
+
+int main() {
+    try {
+        cout << "Goodput (Mbit/s) over a " << link_rate * 8 / 1000.0 << " Mbit/s, " << 2 * link_delay
+             << " ms RTT path with a " << queue_limit / 1000 << " kB drop-tail queue\n";
+        cout << fixed << setprecision(2);
+        for (const auto &recovery : {Recovery{"fixed 1 s RTO", false, false, false, false},
+                                     Recovery{"adaptive RTO", true, false, false, false},
+                                     Recovery{"adaptive RTO and fast retransmit", true, true, false, false},
+                                     Recovery{"adaptive RTO, fast retransmit and SACK", true, true, false, true}}) {
+            cout << "\n" << recovery.name << "\n  loss    none  NewReno    CUBIC      BBR\n";
+            for (const double loss : {0.0, 0.01, 0.02, 0.05}) {
+                const auto loss_rate = static_cast<uint16_t>(loss * UINT16_MAX);
+                cout << setw(5) << loss * 100 << "%";
+                for (const auto algorithm : {CongestionAlgorithm::None,
+                                             CongestionAlgorithm::NewReno,
+                                             CongestionAlgorithm::Cubic,
+                                             CongestionAlgorithm::Bbr}) {
+                    cout << setw(9) << transfer(algorithm, loss_rate, recovery).goodput;
+                }
+                cout << "\n";
+            }
+        }
+
+        cout << "\nadaptive RTO and fast retransmit, no random loss: bursts vs. pacing\n"
+             << "               goodput  queue drops  queueing delay (ms)\n";
+        for (const auto algorithm : {CongestionAlgorithm::NewReno, CongestionAlgorithm::Cubic}) {
+            for (const auto &recovery :
+                 {Recovery{"bursts", true, true, false, false}, Recovery{"paced", true, true, true, false}}) {
+                const auto result = transfer(algorithm, 0, recovery);
+                cout << setw(7) << algorithm_name(algorithm) << " "
+                     << setw(6) << recovery.name << setw(9) << result.goodput << setw(13) << result.uplink.drops
+                     << setw(21) << result.uplink.queueing_delay() << "\n";
+            }
+        }
+
+        cout << "\nadaptive RTO, fast retransmit and SACK, a " << deep_queue_limit / 1000 << " kB queue and a "
+             << deep_window / 1024 << " KiB window\n"
+             << "  loss  algorithm  goodput  queue drops  queueing delay (ms)  RTT inflation  RTOs\n";
+        for (const double loss : {0.0, 0.01}) {
+            const auto loss_rate = static_cast<uint16_t>(loss * UINT16_MAX);
+            for (const auto algorithm :
+                 {CongestionAlgorithm::NewReno, CongestionAlgorithm::Cubic, CongestionAlgorithm::Bbr}) {
+                const Recovery sack{"", true, true, false, true};
+                const auto result = transfer(algorithm, loss_rate, sack, deep_queue_limit, deep_window);
+                const double base_rtt = 2 * link_delay;
+                cout << setw(5) << loss * 100 << "%" << setw(11) << algorithm_name(algorithm) << setw(9)
+                     << result.goodput << setw(13) << result.uplink.drops << setw(21)
+                     << result.uplink.queueing_delay() << setw(14)
+                     << (base_rtt + result.uplink.queueing_delay()) / base_rtt << "x" << setw(6)
+                     << result.timeouts << "\n";
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
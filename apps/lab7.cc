@@ -114,6 +114,8 @@ class NetworkInterfaceAdapter : public TCPOverIPv4Adapter {
         _interface.tick(ms_since_last_tick);
         send_pending();
     }
+    //! Ethernet carries 1500-byte IP datagrams
+    size_t mss() const { return mss_for(1500 - IPv4Header::LENGTH); }
     NetworkInterface &interface() { return _interface; }
     queue<EthernetFrame> frames_out() { return _interface.frames_out(); }
 
@@ -0,0 +1,99 @@
+#include "stream_reassembler.hh"
+#include "tcp_config.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// count every trip to the heap made while a benchmark is running
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    ++allocations;
+    if (void *ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+constexpr size_t num_segments = 100'000;
+constexpr size_t segment_size = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! \returns the order in which the segments arrive: each one is swapped with one of the
+//! next eight with probability `reorder`
+vector<size_t> arrival_order(const double reorder, mt19937 &rd) {
+    vector<size_t> order(num_segments);
+    iota(order.begin(), order.end(), 0);
+    bernoulli_distribution swapped(reorder);
+    uniform_int_distribution<size_t> distance(1, 8);
+    for (size_t i = 0; i + 8 < num_segments; ++i) {
+        if (swapped(rd)) {
+            swap(order[i], order[i + distance(rd)]);
+        }
+    }
+    return order;
+}
+
+void benchmark(const string_view name,
+               const StreamReassembler::Backend backend,
+               const double reorder,
+               const string &data,
+               const vector<size_t> &order) {
+    StreamReassembler reassembler{TCPConfig::DEFAULT_CAPACITY, backend};
+    auto &output = reassembler.stream_out();
+
+    allocations = 0;
+    const auto first_time = high_resolution_clock::now();
+    for (const auto i : order) {
+        const auto index = i * segment_size;
+        reassembler.push_substring(string_view(data).substr(index, segment_size), index, i + 1 == num_segments);
+        // the application keeps up with the stream
+        output.commit_read(output.buffer_size());
+    }
+    const auto final_time = high_resolution_clock::now();
+    const auto allocs = allocations;
+
+    if (not output.eof() or output.bytes_read() != data.size()) {
+        throw runtime_error("the stream was not reassembled");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    cout << fixed << setprecision(2);
+    cout << setw(5) << name << " reassembler, " << setw(2) << int(reorder * 100) << "% reordered: " << setw(8)
+         << allocs << " allocations (" << double(allocs) / num_segments << " per segment), "
+         << data.size() * 8.0 / double(duration) << " Gbit/s\n";
+}
+
+int main() {
+    try {
+        mt19937 rd{144};
+        string data(num_segments * segment_size, 0);
+        generate(data.begin(), data.end(), [&] { return rd(); });
+
+        for (const double reorder : {0.1, 0.3}) {
+            const auto order = arrival_order(reorder, rd);
+            benchmark("queue", StreamReassembler::Backend::Queue, reorder, data, order);
+            benchmark("slab", StreamReassembler::Backend::Slab, reorder, data, order);
+            benchmark("ring", StreamReassembler::Backend::Ring, reorder, data, order);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
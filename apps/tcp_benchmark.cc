@@ -1,10 +1,20 @@
+#include "address.hh"
+#include "memory_budget.hh"
 #include "tcp_connection.hh"
+#include "tcp_stack.hh"
+#include "timer_wheel.hh"
 
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <string>
+#include <string_view>
+#include <utility>
 
 using namespace std;
 using namespace std::chrono;
@@ -28,8 +38,9 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder, const StreamReassembler::Backend backend) {
     TCPConfig config;
+    config.reassembler = backend;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -95,18 +106,654 @@ void main_loop(const bool reorder) {
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    cout << "CPU-limited throughput" << (reorder ? " with reordering" : "                ")
+         << (backend == StreamReassembler::Backend::Ring ? " (ring reassembler) " : " (queue reassembler)") << ": "
+         << gigabits_per_second << " Gbit/s\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
-int main() {
+//! The bytes of an endless stream, generated on demand: byte `i` is `block[i % block.size()]`.
+//! The block's size is prime, so bytes that land a power of two (e.g. 4 GiB) away from where they
+//! belong don't match.
+class StreamPattern {
+    string block;  //!< the block, twice over, so that any window of one block's size is contiguous
+
+  public:
+    static constexpr size_t BLOCK_SIZE = 1'000'003;
+
+    StreamPattern() : block(BLOCK_SIZE, 0) {
+        for (auto &ch : block) {
+            ch = rand();
+        }
+        block += block;
+    }
+
+    //! \returns the bytes [offset, offset + size), for size <= BLOCK_SIZE
+    string_view view(const uint64_t offset, const size_t size) const {
+        return string_view(block).substr(offset % BLOCK_SIZE, size);
+    }
+};
+
+//! Stream `total` bytes from x to y with reordering, without ever holding the whole stream,
+//! checking every byte on arrival and reporting the throughput of each GiB along the way.
+void streaming_loop(const uint64_t total, const StreamReassembler::Backend backend) {
+    constexpr uint64_t report_interval = uint64_t(1) << 30;
+
+    TCPConfig config;
+    config.reassembler = backend;
+    TCPConnection x{config}, y{config};
+    const StreamPattern pattern;
+
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+    uint64_t sent = 0, received = 0, next_report = report_interval;
+    auto interval_time = high_resolution_clock::now();
+    const auto first_time = interval_time;
+
+    vector<TCPSegment> segments;
+    while (not y.inbound_stream().eof()) {
+        while (sent < total and x.remaining_outbound_capacity()) {
+            const auto want = min<uint64_t>({x.remaining_outbound_capacity(), total - sent, StreamPattern::BLOCK_SIZE});
+            sent += x.write(string(pattern.view(sent, want)));
+        }
+        if (sent == total and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        move_segments(x, y, segments, true);
+        move_segments(y, x, segments, false);
+
+        auto &inbound = y.inbound_stream();
+        for (const auto view : inbound.peek_view()) {
+            if (view != pattern.view(received, view.size())) {
+                throw runtime_error("corrupted bytes at offset " + to_string(received));
+            }
+            received += view.size();
+            inbound.commit_read(view.size());
+        }
+
+        if (received >= next_report) {
+            const auto now = high_resolution_clock::now();
+            const auto duration = duration_cast<nanoseconds>(now - interval_time).count();
+            cout << fixed << setprecision(2) << "  " << setw(6) << double(received) / report_interval
+                 << " GiB received: " << (received - next_report + report_interval) * 8.0 / double(duration)
+                 << " Gbit/s\n";
+            interval_time = now;
+            next_report = received + report_interval;
+        }
+
+        x.tick(1000);
+        y.tick(1000);
+    }
+
+    if (received != total) {
+        throw runtime_error("received " + to_string(received) + " of " + to_string(total) + " bytes");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+    while (x.active() or y.active()) {
+        move_segments(x, y, segments, true);
+        move_segments(y, x, segments, false);
+        x.tick(1000);
+        y.tick(1000);
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "Streamed " << double(total) / report_interval << " GiB with reordering: " << total * 8.0 / double(duration)
+         << " Gbit/s\n";
+}
+
+//! Send `len` bytes from x to y in segments of at most `mss` bytes, and report segments and bits per second.
+//! Both ends hold a scaled 1 MiB window, so that even the largest segments leave the window room.
+void mss_loop(const size_t mss) {
+    TCPConfig config;
+    config.mss = mss;
+    config.recv_capacity = config.send_capacity = 1024 * 1024;
+    config.window_scaling = true;
+    config.reassembler = StreamReassembler::Backend::Ring;
+    TCPConnection x{config}, y{config};
+
+    const string block(config.send_capacity, 'x');
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+    uint64_t sent = 0, received = 0, segments_sent = 0;
+    const auto first_time = high_resolution_clock::now();
+
+    vector<TCPSegment> segments;
+    while (not y.inbound_stream().eof()) {
+        while (sent < len and x.remaining_outbound_capacity()) {
+            sent += x.write(block.substr(0, min<uint64_t>(x.remaining_outbound_capacity(), len - sent)));
+        }
+        if (sent == len and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        segments_sent += x.segments_out().size();
+        move_segments(x, y, segments, false);
+        move_segments(y, x, segments, false);
+
+        received += y.inbound_stream().buffer_size();
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+
+        x.tick(1000);
+        y.tick(1000);
+    }
+
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+    if (received != len) {
+        throw runtime_error("received " + to_string(received) + " of " + to_string(len) + " bytes");
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "CPU-limited throughput with MSS " << setw(5) << mss << ": " << setw(6)
+         << segments_sent * 1e3 / double(duration) << " Msegments/s, " << setw(6) << len * 8.0 / double(duration)
+         << " Gbit/s\n";
+
+    while (x.active() or y.active()) {
+        move_segments(x, y, segments, false);
+        move_segments(y, x, segments, false);
+        x.tick(1000);
+        y.tick(1000);
+    }
+}
+
+//! Send `len` bytes from x to y, dropping each data segment with probability `loss`, one millisecond per round,
+//! and report how much the sender had to retransmit with fast recovery, with or without SACK.
+void lossy_loop(const double loss, const bool sack) {
+    TCPConfig config;
+    config.fast_retransmit = true;
+    config.adaptive_rto = true;
+    config.sack = sack;
+    TCPConnection x{config}, y{config};
+
+    const string block(TCPConfig::DEFAULT_CAPACITY, 'x');
+    x.connect();
+    y.end_input_stream();
+
+    mt19937 rng{len};
+    bernoulli_distribution drop{loss};
+    bool x_closed = false;
+    uint64_t sent = 0, received = 0, rounds = 0, dropped = 0;
+    const auto first_time = high_resolution_clock::now();
+
+    vector<TCPSegment> segments;
+    while (not y.inbound_stream().eof()) {
+        while (sent < len and x.remaining_outbound_capacity()) {
+            sent += x.write(block.substr(0, min<uint64_t>(x.remaining_outbound_capacity(), len - sent)));
+        }
+        if (sent == len and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        while (not x.segments_out().empty()) {
+            const auto size = x.segments_out().front().payload().size();
+            if (size > 0 and drop(rng)) {
+                dropped += size;
+            } else {
+                segments.emplace_back(move(x.segments_out().front()));
+            }
+            x.segments_out().pop();
+        }
+        for (auto &seg : segments) {
+            y.segment_received(move(seg));
+        }
+        segments.clear();
+        move_segments(y, x, segments, false);
+
+        received += y.inbound_stream().buffer_size();
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+
+        x.tick(1);
+        y.tick(1);
+        ++rounds;
+    }
+
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+    if (received != len) {
+        throw runtime_error("received " + to_string(received) + " of " + to_string(len) + " bytes");
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "CPU-limited throughput with " << loss * 100 << "% loss" << (sack ? " and SACK   " : ", without SACK")
+         << ": " << len * 8.0 / double(duration) << " Gbit/s, " << rounds << " rounds, "
+         << x.sender().retransmitted_bytes() << " bytes retransmitted for " << dropped << " lost\n";
+
+    while (x.active() or y.active()) {
+        move_segments(x, y, segments, false);
+        move_segments(y, x, segments, false);
+        x.tick(1);
+        y.tick(1);
+    }
+}
+
+//! Send `len` bytes from x to y and report how many segments each direction carried, with or without delayed ACKs.
+//! One round is a millisecond, so that the ACK delay spans several rounds.
+void ack_loop(const bool delayed_ack) {
+    TCPConfig config;
+    config.delayed_ack = delayed_ack;
+    config.reassembler = StreamReassembler::Backend::Ring;
+    TCPConnection x{config}, y{config};
+
+    const string block(TCPConfig::DEFAULT_CAPACITY, 'x');
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+    uint64_t sent = 0, received = 0, data_segments = 0, ack_segments = 0;
+    const auto first_time = high_resolution_clock::now();
+
+    vector<TCPSegment> segments;
+    while (not y.inbound_stream().eof()) {
+        while (sent < len and x.remaining_outbound_capacity()) {
+            sent += x.write(block.substr(0, min<uint64_t>(x.remaining_outbound_capacity(), len - sent)));
+        }
+        if (sent == len and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        data_segments += x.segments_out().size();
+        move_segments(x, y, segments, false);
+        ack_segments += y.segments_out().size();
+        move_segments(y, x, segments, false);
+
+        received += y.inbound_stream().buffer_size();
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+
+        x.tick(1);
+        y.tick(1);
+    }
+
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+    if (received != len) {
+        throw runtime_error("received " + to_string(received) + " of " + to_string(len) + " bytes");
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "CPU-limited throughput " << (delayed_ack ? "with delayed ACKs   " : "ACKing every segment") << ": "
+         << len * 8.0 / double(duration) << " Gbit/s, " << data_segments << " data segments, " << ack_segments
+         << " ACKs (" << double(ack_segments) / double(data_segments) << " per data segment)\n";
+
+    while (x.active() or y.active()) {
+        move_segments(x, y, segments, false);
+        move_segments(y, x, segments, false);
+        x.tick(1);
+        y.tick(1);
+    }
+}
+
+//! How writes_loop's sender coalesces its small writes
+enum class Coalescing { NoDelay, Nagle, Cork, NagleDelayedAck };
+
+//! Have x make ten 100-byte writes a round and report how many segments carry them, and how many rounds
+//! a byte waits on average between its write and its arrival at y. One round is a millisecond.
+void writes_loop(const Coalescing coalescing) {
+    constexpr uint64_t rounds = 10000, writes = 10, write_size = 100;
+
+    TCPConfig config;
+    config.nagle = coalescing == Coalescing::Nagle or coalescing == Coalescing::NagleDelayedAck;
+    TCPConfig peer_config;
+    peer_config.delayed_ack = coalescing == Coalescing::NagleDelayedAck;
+    TCPConnection x{config}, y{peer_config};
+
+    const string block(write_size, 'x');
+    x.connect();
+    y.end_input_stream();
+
+    uint64_t sent = 0, received = 0, data_segments = 0, delay = 0;
+    deque<pair<uint64_t, uint64_t>> writes_made;  // (bytes written so far, round of the write)
+
+    vector<TCPSegment> segments;
+    for (uint64_t round = 0; not y.inbound_stream().eof(); ++round) {
+        if (round < rounds) {
+            if (coalescing == Coalescing::Cork) {
+                x.cork();
+            }
+            for (uint64_t i = 0; i < writes; ++i) {
+                sent += x.write(block);
+                writes_made.emplace_back(sent, round);
+            }
+            if (coalescing == Coalescing::Cork) {
+                x.uncork();
+            }
+        } else if (round == rounds) {
+            x.end_input_stream();
+        }
+
+        while (not x.segments_out().empty()) {
+            data_segments += x.segments_out().front().payload().size() > 0;
+            y.segment_received(move(x.segments_out().front()));
+            x.segments_out().pop();
+        }
+        move_segments(y, x, segments, false);
+
+        received += y.inbound_stream().buffer_size();
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+        while (not writes_made.empty() and writes_made.front().first <= received) {
+            delay += round - writes_made.front().second;
+            writes_made.pop_front();
+        }
+
+        x.tick(1);
+        y.tick(1);
+    }
+
+    if (received != rounds * writes * write_size) {
+        throw runtime_error("received " + to_string(received) + " of " + to_string(sent) + " bytes");
+    }
+
+    static const char *const names[] = {"TCP_NODELAY          ", "Nagle                ", "cork/uncork per round",
+                                        "Nagle, delayed ACKs  "};
+    cout << fixed << setprecision(2);
+    cout << "100-byte writes with " << names[size_t(coalescing)] << ": " << data_segments << " data segments ("
+         << double(received) / double(data_segments) << " bytes each), "
+         << double(delay) / double(rounds * writes) << " rounds of delay on average\n";
+
+    while (x.active() or y.active()) {
+        move_segments(x, y, segments, false);
+        move_segments(y, x, segments, false);
+        x.tick(1);
+        y.tick(1);
+    }
+}
+
+//! Hold `count` established connections, one in a hundred with data its vanished peer never
+//! acknowledges, and let two seconds pass: first ticking each connection every millisecond, then
+//! ticking them from a TimerWheel only when their timers are due.
+void idle_loop(const size_t count) {
+    TCPConfig config;
+    config.send_capacity = config.recv_capacity = 1024;
+    config.fixed_isn = WrappingInt32{0};
+    constexpr uint64_t duration = 2000;
+
+    const auto establish = [&] {
+        vector<unique_ptr<TCPConnection>> conns;
+        for (size_t i = 0; i < count; ++i) {
+            auto &conn = *conns.emplace_back(make_unique<TCPConnection>(config));
+            TCPSegment syn;
+            syn.header().syn = true;
+            conn.segment_received(syn);
+            conn.segments_out().pop();
+            TCPSegment ack;
+            ack.header().seqno = WrappingInt32{1};
+            ack.header().ack = true;
+            ack.header().ackno = WrappingInt32{1};
+            ack.header().win = 1024;
+            conn.segment_received(ack);
+            if (i % 100 == 0) {
+                conn.write("lost");
+                conn.segments_out().pop();
+            }
+        }
+        return conns;
+    };
+    const auto reset = [](vector<unique_ptr<TCPConnection>> &conns) {
+        TCPSegment rst;
+        rst.header().seqno = WrappingInt32{1};
+        rst.header().rst = true;
+        for (auto &conn : conns) {
+            conn->segment_received(rst);
+        }
+    };
+
+    cout << fixed << setprecision(2);
+    {
+        auto conns = establish();
+        size_t segments = 0;
+        const auto first_time = high_resolution_clock::now();
+        for (uint64_t ms = 0; ms < duration; ++ms) {
+            for (auto &conn : conns) {
+                conn->tick(1);
+                while (not conn->segments_out().empty()) {
+                    conn->segments_out().pop();
+                    ++segments;
+                }
+            }
+        }
+        const auto elapsed = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+        cout << count << " connections ticked every ms:     " << double(elapsed) / duration << " ns per ms, "
+             << segments << " retransmissions\n";
+        reset(conns);
+    }
+    {
+        auto conns = establish();
+        TimerWheel wheel;
+        vector<unique_ptr<WheelTicker<TCPConnection>>> tickers;
+        for (auto &conn : conns) {
+            tickers.emplace_back(make_unique<WheelTicker<TCPConnection>>(wheel, *conn));
+        }
+        const auto armed = wheel.size();
+        size_t segments = 0;
+        const auto first_time = high_resolution_clock::now();
+        for (uint64_t ms = 0; ms < duration; ++ms) {
+            wheel.advance(1);
+            // the owner would learn of these from the connections it just ticked; sweeping them all
+            // here would cost what the wheel saves
+            if (ms % 1000 == 999) {
+                for (auto &conn : conns) {
+                    while (not conn->segments_out().empty()) {
+                        conn->segments_out().pop();
+                        ++segments;
+                    }
+                }
+            }
+        }
+        const auto elapsed = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+        cout << count << " connections ticked from a wheel: " << double(elapsed) / duration << " ns per ms, "
+             << segments << " retransmissions, " << armed << " timers armed\n";
+        tickers.clear();
+        reset(conns);
+    }
+}
+
+//! Open `count` connections between two TCPStacks across a 20 ms RTT, send `bulk` bytes over every tenth
+//! and a few bytes over the rest, and report the throughput of the busy ones and the memory the receive
+//! buffers took, with buffers of `capacity` bytes that grow up to 1 MiB if `autotune`.
+void autotune_loop(const size_t count, const size_t capacity, const bool autotune) {
+    constexpr uint64_t one_way_delay = 10;
+    constexpr uint64_t bulk = 4 * 1024 * 1024;
+    TCPConfig config;
+    config.window_scaling = true;
+    config.recv_capacity = capacity;
+    config.recv_autotune = autotune;
+    config.recv_capacity_max = 1024 * 1024;
+    TCPConfig server_config = config;
+    const auto budget = make_shared<MemoryBudget>(SIZE_MAX);
+    server_config.recv_budget = budget;
+    TCPStack client{config}, server{server_config};
+    server.listen(80, {count, count});
+
+    struct InFlight {
+        uint64_t due;
+        TCPStack *to;
+        FourTuple tuple;
+        TCPSegment seg;
+    };
+    deque<InFlight> link;
+    const auto transmit = [&](TCPStack &from, TCPStack &to, const uint64_t now) {
+        while (not from.segments_out().empty()) {
+            auto &[tuple, seg] = from.segments_out().front();
+            const FourTuple peer_tuple{tuple.remote_address, tuple.local_address, tuple.remote_port, tuple.local_port};
+            link.push_back({now + one_way_delay, &to, peer_tuple, move(seg)});
+            from.segments_out().pop();
+        }
+    };
+
+    // connection i comes from the i-th ephemeral port, and every tenth one is busy
+    const auto busy = [](const size_t i) { return i % 10 == 0; };
+    vector<TCPStack::ConnectionId> conns, peers;
+    vector<uint64_t> sent(count), received(count);
+    for (size_t i = 0; i < count; ++i) {
+        conns.push_back(client.connect(Address{"10.0.0.2", 0}, Address{"10.0.0.1", 80}));
+        sent[i] = client.write(conns[i], busy(i) ? "" : "ping");
+    }
+
+    const string block(TCPConfig::DEFAULT_CAPACITY, 'x');
+    const size_t busy_count = (count + 9) / 10;
+    size_t done = 0, peak = 0;
+    uint64_t now = 0;
+    const auto first_time = high_resolution_clock::now();
+    while (done < busy_count) {
+        while (not link.empty() and link.front().due <= now) {
+            link.front().to->segment_received(link.front().tuple, link.front().seg);
+            link.pop_front();
+        }
+        while (const auto peer = server.accept(80)) {
+            peers.push_back(*peer);
+        }
+        for (const auto peer : peers) {
+            auto &stream = server.inbound_stream(peer);
+            const auto i = server.tuple(peer).remote_port - TCPStack::EPHEMERAL_PORTS_BEGIN;
+            received[i] += stream.buffer_size();
+            stream.pop_output(stream.buffer_size());
+            if (busy(i) and received[i] == bulk and sent[i] == bulk) {
+                ++done;
+                ++sent[i];
+            }
+        }
+        for (size_t i = 0; i < count; i += 10) {
+            while (sent[i] < bulk) {
+                const auto size = min<uint64_t>(block.size(), bulk - sent[i]);
+                const auto written = client.write(conns[i], block.substr(0, size));
+                if (written == 0) {
+                    break;
+                }
+                sent[i] += written;
+            }
+        }
+        peak = max(peak, budget->used());
+        client.tick(1);
+        server.tick(1);
+        ++now;
+        transmit(client, server, now);
+        transmit(server, client, now);
+    }
+    const auto elapsed = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+    const auto settled = budget->used();
+
+    cout << fixed << setprecision(2);
+    cout << count << " connections, " << (autotune ? "autotuned" : "fixed") << " receive buffers of " << setw(4)
+         << capacity / 1024 << " KiB: " << setw(6) << bulk * 8.0 / double(now * 1000) << " Mbit/s per busy connection, "
+         << setw(7) << double(peak) / double(count) / 1024 << " KiB per connection at peak, " << setw(7)
+         << double(settled) / double(count) / 1024 << " at the end, " << double(elapsed) / 1e9 << " s\n";
+
+    for (const auto conn : conns) {
+        client.close(conn);
+    }
+    for (const auto peer : peers) {
+        server.close(peer);
+    }
+    while (client.size() > 0 or server.size() > 0) {
+        while (not link.empty() and link.front().due <= now) {
+            link.front().to->segment_received(link.front().tuple, link.front().seg);
+            link.pop_front();
+        }
+        client.tick(1);
+        server.tick(1);
+        ++now;
+        transmit(client, server, now);
+        transmit(server, client, now);
+    }
+}
+
+void print_usage(const string &argv0) {
+    cerr << "Usage: " << argv0 << "\n";
+    cerr << "or     " << argv0 << " stream GIGABYTES [queue|ring|slab]\n";
+    cerr << "or     " << argv0 << " loss [PERCENT]\n";
+    cerr << "or     " << argv0 << " mss [MSS...]\n";
+    cerr << "or     " << argv0 << " acks\n";
+    cerr << "or     " << argv0 << " writes\n";
+    cerr << "or     " << argv0 << " idle [CONNECTIONS]\n";
+    cerr << "or     " << argv0 << " autotune [CONNECTIONS]\n";
+}
+
+int main(int argc, char *argv[]) {
     try {
-        main_loop(false);
-        main_loop(true);
+        if (argc <= 0) {
+            abort();  // For sticklers: don't try to access argv[0] if argc <= 0.
+        }
+
+        if (argc >= 3 and argc <= 4 and argv[1] == "stream"s) {
+            auto backend = StreamReassembler::Backend::Ring;
+            if (argc == 4) {
+                if (argv[3] == "queue"s) {
+                    backend = StreamReassembler::Backend::Queue;
+                } else if (argv[3] == "slab"s) {
+                    backend = StreamReassembler::Backend::Slab;
+                } else if (argv[3] != "ring"s) {
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            }
+            streaming_loop(uint64_t(stod(argv[2]) * 1e9), backend);
+            return EXIT_SUCCESS;
+        }
+
+        if (argc >= 2 and argc <= 3 and argv[1] == "loss"s) {
+            const double loss = argc == 3 ? stod(argv[2]) / 100 : 0.01;
+            lossy_loop(loss, false);
+            lossy_loop(loss, true);
+            return EXIT_SUCCESS;
+        }
+
+        if (argc >= 2 and argv[1] == "mss"s) {
+            if (argc == 2) {
+                for (const size_t mss : {536, 1000, 1460, 4000, 8960, 16384, 65495}) {
+                    mss_loop(mss);
+                }
+            }
+            for (int i = 2; i < argc; ++i) {
+                mss_loop(stoul(argv[i]));
+            }
+            return EXIT_SUCCESS;
+        }
+
+        if (argc == 2 and argv[1] == "acks"s) {
+            ack_loop(false);
+            ack_loop(true);
+            return EXIT_SUCCESS;
+        }
+
+        if (argc == 2 and argv[1] == "writes"s) {
+            for (const auto coalescing :
+                 {Coalescing::NoDelay, Coalescing::Nagle, Coalescing::Cork, Coalescing::NagleDelayedAck}) {
+                writes_loop(coalescing);
+            }
+            return EXIT_SUCCESS;
+        }
+
+        if (argc >= 2 and argc <= 3 and argv[1] == "idle"s) {
+            idle_loop(argc == 3 ? stoul(argv[2]) : 100000);
+            return EXIT_SUCCESS;
+        }
+
+        if (argc >= 2 and argc <= 3 and argv[1] == "autotune"s) {
+            const size_t count = argc == 3 ? stoul(argv[2]) : 1000;
+            autotune_loop(count, 16 * 1024, false);
+            autotune_loop(count, 1024 * 1024, false);
+            autotune_loop(count, 16 * 1024, true);
+            return EXIT_SUCCESS;
+        }
+
+        if (argc != 1) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        for (const auto backend : {StreamReassembler::Backend::Queue, StreamReassembler::Backend::Ring}) {
+            main_loop(false, backend);
+            main_loop(true, backend);
+        }
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -78,6 +78,8 @@ static tuple<TCPConfig, FdAdapterConfig, Address, string> get_config(int argc, c
         } else if (strncmp("-w", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -w requires one argument.");
             c_fsm.recv_capacity = strtol(argv[curr + 1], nullptr, 0);
+            // a window beyond 64 KiB can only be advertised scaled
+            c_fsm.window_scaling = c_fsm.recv_capacity > UINT16_MAX;
             curr += 2;
 
         } else if (strncmp("-t", argv[curr], 3) == 0) {
@@ -2,6 +2,7 @@
 #include "tcp_config.hh"
 #include "tcp_sponge_socket.hh"
 
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -61,6 +62,8 @@ static tuple<TCPConfig, FdAdapterConfig, bool> get_config(int argc, char **argv)
         } else if (strncmp("-w", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -w requires one argument.");
             c_fsm.recv_capacity = strtol(argv[curr + 1], nullptr, 0);
+            // a window beyond 64 KiB can only be advertised scaled
+            c_fsm.window_scaling = c_fsm.recv_capacity > UINT16_MAX;
             curr += 2;
 
         } else if (strncmp("-t", argv[curr], 3) == 0) {
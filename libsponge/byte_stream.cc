@@ -1,10 +1,13 @@
 #include "byte_stream.hh"
 
+#include "util.hh"
+
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
@@ -15,9 +18,67 @@
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t cap) : buf(cap), capacity(cap) { buf.resize(cap); }
+//! \returns the smallest power of two that is not less than `size`
+static size_t roundUpPow2(const size_t size) {
+    size_t res = 1;
+    while (res < size) {
+        res <<= 1;
+    }
+    return res;
+}
+
+ByteStream::ByteStream(const size_t cap, const Mode mode_)
+    : buf(mode_ == Mode::Ring ? roundUpPow2(cap) : 0)
+    , mirror(mode_ == Mode::Mirrored ? std::optional<MirroredMemory>(std::in_place, cap) : std::nullopt)
+    , capacity(cap)
+    , mode(mode_)
+    , mask(mode_ == Mode::Chunked ? 0 : mirror ? mirror->size() - 1 : roundUpPow2(cap) - 1) {}
+
+//! \details The whole ring moves, not only the unread bytes: the bytes past them, which
+//! StreamReassembler::Backend::Ring stores ahead of the writer, keep their place in the stream too.
+void ByteStream::grow(const size_t cap) {
+    if (cap <= capacity) {
+        return;
+    }
+    capacity = cap;
+    if (mode == Mode::Chunked || cap <= mask + 1) {
+        return;
+    }
+    auto newMirror = mode == Mode::Mirrored ? optional<MirroredMemory>(in_place, cap) : nullopt;
+    vector<uint8_t> newBuf(newMirror ? 0 : roundUpPow2(cap));
+    uint8_t *to = newMirror ? newMirror->data() : newBuf.data();
+    const size_t newMask = (newMirror ? newMirror->size() : newBuf.size()) - 1;
+    for (size_t done = 0; done <= mask;) {
+        const auto from = (readerSeq + done) & mask;
+        const auto dst = (readerSeq + done) & newMask;
+        const auto size = std::min({mask + 1 - done, mask + 1 - from, newMask + 1 - dst});
+        memcpy(to + dst, ring() + from, size);
+        done += size;
+    }
+    buf = move(newBuf);
+    mirror = move(newMirror);
+    mask = newMask;
+}
+
+size_t ByteStream::footprint(const size_t cap) const {
+    // the storage never shrinks
+    const auto size = std::max(cap, capacity);
+    switch (mode) {
+        case Mode::Ring:
+            return roundUpPow2(size);
+        case Mode::Mirrored:
+            // the second mapping is of the same pages
+            return MirroredMemory::size_for(size);
+        case Mode::Chunked:
+            break;
+    }
+    return size;
+}
 
 size_t ByteStream::write(const string &data) {
+    if (mode == Mode::Chunked) {
+        return write(string(data, 0, remaining_capacity()));
+    }
     const auto avaliable = remaining_capacity();
     if (avaliable == 0) {
         return 0;
@@ -25,7 +86,39 @@ size_t ByteStream::write(const string &data) {
     const auto res = std::min(avaliable, data.size());
     writeBytes(reinterpret_cast<const uint8_t *>(data.data()), res);
     writerSeq += res;
-    prod = writerSeq % capacity;
+    return res;
+}
+
+size_t ByteStream::write(string &&data) {
+    if (mode != Mode::Chunked) {
+        return write(static_cast<const string &>(data));
+    }
+    const auto res = std::min(remaining_capacity(), data.size());
+    if (res == 0) {
+        return 0;
+    }
+    data.resize(res);
+    if (data.capacity() / 2 > res) {
+        // don't pin a mostly empty allocation for as long as the bytes are queued
+        data.shrink_to_fit();
+    }
+    chunks.emplace_back(std::move(data));
+    writerSeq += res;
+    return res;
+}
+
+size_t ByteStream::write(const Buffer &data) {
+    const auto res = std::min(remaining_capacity(), data.size());
+    if (res == 0) {
+        return 0;
+    }
+    if (mode != Mode::Chunked) {
+        writeBytes(reinterpret_cast<const uint8_t *>(data.str().data()), res);
+        writerSeq += res;
+        return res;
+    }
+    chunks.push_back(data.prefix(res));
+    writerSeq += res;
     return res;
 }
 
@@ -36,6 +129,17 @@ string ByteStream::peek_output(const size_t len) const {
     if (readAvaliable == 0) {
         return res;
     }
+    if (mode == Mode::Chunked) {
+        res.reserve(readAvaliable);
+        for (const auto &chunk : chunks) {
+            const auto part = std::min(chunk.size(), readAvaliable - res.size());
+            res.append(chunk.str().substr(0, part));
+            if (res.size() == readAvaliable) {
+                break;
+            }
+        }
+        return res;
+    }
     res.resize(readAvaliable);
     readBytes(reinterpret_cast<uint8_t *>(res.data()), readAvaliable);
     return res;
@@ -44,8 +148,10 @@ string ByteStream::peek_output(const size_t len) const {
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
     if (len <= buffer_size()) {
+        if (mode == Mode::Chunked) {
+            popChunks(len);
+        }
         readerSeq += len;
-        conm = readerSeq % capacity;
     } else {
         throw std::runtime_error("Remove error");
     }
@@ -56,11 +162,67 @@ void ByteStream::pop_output(const size_t len) {
 //! \returns a string
 std::string ByteStream::read(const size_t len) {
     auto res = peek_output(len);
-    readerSeq += res.size();
-    conm = readerSeq % capacity;
+    pop_output(res.size());
+    return res;
+}
+
+//! \param[in] len bytes will be shared from the output side of the buffer
+//! \note In the ring modes there is nothing to share, so the bytes are copied into a single Buffer.
+BufferList ByteStream::peek_buffers(const size_t len) const {
+    if (mode != Mode::Chunked) {
+        return BufferList(peek_output(len));
+    }
+    auto remain = std::min(buffer_size(), len);
+    BufferList res;
+    for (auto iter = chunks.cbegin(); remain > 0; ++iter) {
+        const auto part = std::min(iter->size(), remain);
+        res.append(iter->prefix(part));
+        remain -= part;
+    }
     return res;
 }
 
+//! \param[in] len bytes will be popped and returned
+BufferList ByteStream::read_buffer(const size_t len) {
+    auto res = peek_buffers(len);
+    pop_output(res.size());
+    return res;
+}
+
+array<iovec, 2> ByteStream::writable_spans() {
+    if (mode == Mode::Chunked) {
+        throw runtime_error("ByteStream::writable_spans requires a ring mode");
+    }
+    const auto avaliable = remaining_capacity();
+    const auto prod = writerSeq & mask;
+    const auto part1 = contiguous(prod, avaliable);
+    return {iovec{ring() + prod, part1}, iovec{ring(), avaliable - part1}};
+}
+
+void ByteStream::commit_write(const size_t len) {
+    if (mode == Mode::Chunked || len > remaining_capacity()) {
+        throw runtime_error("ByteStream::commit_write");
+    }
+    writerSeq += len;
+}
+
+array<string_view, 2> ByteStream::peek_view(const size_t len) const {
+    const auto readAvaliable = std::min(buffer_size(), len);
+    if (mode == Mode::Chunked) {
+        array<string_view, 2> res{};
+        auto remain = readAvaliable;
+        for (size_t i = 0; i < res.size() && i < chunks.size() && remain > 0; ++i) {
+            res[i] = chunks[i].str().substr(0, remain);
+            remain -= res[i].size();
+        }
+        return res;
+    }
+    const auto *data = reinterpret_cast<const char *>(ring());
+    const auto conm = readerSeq & mask;
+    const auto part1 = contiguous(conm, readAvaliable);
+    return {string_view{data + conm, part1}, string_view{data, readAvaliable - part1}};
+}
+
 void ByteStream::end_input() { flag |= WRITEEND; }
 
 bool ByteStream::input_ended() const { return flag & WRITEEND; }
@@ -76,23 +238,26 @@ size_t ByteStream::bytes_written() const { return writerSeq; }
 size_t ByteStream::bytes_read() const { return readerSeq; }
 
 size_t ByteStream::remaining_capacity() const { return capacity - buffer_size(); }
-void ByteStream::writeBytes(const uint8_t *data, size_t size) noexcept {
-    const auto part1 = capacity - prod;
-    if (part1 >= size) {
-        memcpy(&buf[prod], data, size);
-    } else {
-        const auto part2 = size - part1;
-        memcpy(&buf[prod], data, part1);
-        memcpy(buf.data(), data + part1, part2);
+void ByteStream::popChunks(size_t size) {
+    while (size > 0) {
+        auto &front = chunks.front();
+        if (size < front.size()) {
+            front.remove_prefix(size);
+            return;
+        }
+        size -= front.size();
+        chunks.pop_front();
     }
 }
+void ByteStream::writeBytes(const uint8_t *data, size_t size) noexcept {
+    const auto prod = writerSeq & mask;
+    const auto part1 = contiguous(prod, size);
+    memcpy(ring() + prod, data, part1);
+    memcpy(ring(), data + part1, size - part1);
+}
 void ByteStream::readBytes(uint8_t *data, size_t size) const noexcept {
-    const auto part1 = capacity - conm;
-    if (part1 >= size) {
-        memcpy(data, &buf[conm], size);
-    } else {
-        const auto part2 = size - part1;
-        memcpy(data, &buf[conm], part1);
-        memcpy(data + part1, buf.data(), part2);
-    }
+    const auto conm = readerSeq & mask;
+    const auto part1 = contiguous(conm, size);
+    memcpy(data, ring() + conm, part1);
+    memcpy(data + part1, ring(), size - part1);
 }
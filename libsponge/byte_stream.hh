@@ -1,10 +1,20 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+#include "mirrored_memory.hh"
+
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <vector>
 
 //! \brief An in-order byte stream.
@@ -13,13 +23,24 @@
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
+  public:
+    //! How the stream holds the bytes that have been written but not yet read
+    enum class Mode : uint8_t {
+        Ring,      //!< copy every byte into a flat ring (of `capacity` rounded up to a power of two)
+        Mirrored,  //!< like Ring, but the ring is mapped twice so that every window of it is contiguous
+        Chunked,   //!< keep the writer's strings as a queue of reference-counted Buffers
+    };
+
   private:
     std::vector<uint8_t> buf;
-    const size_t capacity;
+    std::optional<MirroredMemory> mirror;
+    std::deque<Buffer> chunks{};
+    size_t capacity;
+    const Mode mode;
+    //! the ring's size minus one; the ring's size is a power of two, so `seq & mask` is the ring index
+    size_t mask;
     size_t writerSeq{0};
     size_t readerSeq{0};
-    size_t prod{0};
-    size_t conm{0};
     uint8_t flag{0};
     enum Flag : uint8_t {
         ERROR = 1 << 0,
@@ -28,10 +49,19 @@ class ByteStream {
     // bool _error{};  //!< Flag indicating that the stream suffered an error.
     void writeBytes(const uint8_t *data, size_t size) noexcept;
     void readBytes(uint8_t *data, size_t size) const noexcept;
+    void popChunks(size_t size);
+    uint8_t *ring() { return mirror ? mirror->data() : buf.data(); }
+    const uint8_t *ring() const { return mirror ? mirror->data() : buf.data(); }
+    //! \returns how many of `size` bytes starting at ring index `pos` can be copied in one piece
+    size_t contiguous(const size_t pos, const size_t size) const {
+        return mirror ? size : std::min(mask + 1 - pos, size);
+    }
 
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t cap);
+    //! \note Mode::Mirrored takes a memfd and two mappings per stream, and throws a unix_error if it can't have
+    //! them (e.g. once a process holds tens of thousands and runs into vm.max_map_count)
+    ByteStream(const size_t cap, const Mode mode_ = Mode::Ring);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -41,12 +71,40 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a string of bytes into the stream, taking ownership of it.
+    //! In Mode::Chunked the string is kept as is (truncated if it does not fit), without copying.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data);
+
+    //! Write a Buffer into the stream. In Mode::Chunked the Buffer's storage is shared, not copied.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const Buffer &data);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
+    //! \returns up to two regions covering the free space of the ring, in stream order;
+    //! the second one is empty unless the free space wraps around (never in Mode::Mirrored)
+    std::array<iovec, 2> writable_spans();
+
+    //! Append `len` bytes that were filled in through writable_spans() to the stream
+    void commit_write(const size_t len);
+
     //! Signal that the byte stream has reached its ending
     void end_input();
 
+    //! \brief Make room for `cap` bytes (does nothing if there is room already)
+    //! \note In Mode::Ring and Mode::Mirrored this moves the bytes to a bigger ring, which invalidates the
+    //! spans and views handed out before
+    void grow(const size_t cap);
+
+    //! \returns the number of bytes the stream may hold
+    size_t max_size() const { return capacity; }
+
+    //! \returns the bytes the stream's storage takes once it may hold `cap` bytes: the whole ring, rounded up,
+    //! or in Mode::Chunked the most its chunks can hold
+    size_t footprint(const size_t cap) const;
+
     //! Indicate that the stream suffered an error.
     void set_error() { flag |= ERROR; }
     //!@}
@@ -61,10 +119,26 @@ class ByteStream {
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
+    //! View the next "len" bytes of the stream in place, without copying
+    //! \returns up to two views in stream order; the second one is empty unless the bytes wrap
+    //! around the ring (never in Mode::Mirrored; in Mode::Chunked, the views cover the first two chunks)
+    std::array<std::string_view, 2> peek_view(const size_t len = std::numeric_limits<size_t>::max()) const;
+
+    //! Remove `len` bytes that were consumed through peek_view() from the buffer
+    void commit_read(const size_t len) { pop_output(len); }
+
     //! Read (i.e., copy and then pop) the next "len" bytes of the stream
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Peek at next "len" bytes of the stream without copying them (in Mode::Chunked)
+    //! \returns a BufferList sharing storage with the stream
+    BufferList peek_buffers(const size_t len) const;
+
+    //! Read (i.e., share and then pop) the next "len" bytes of the stream
+    //! \returns a BufferList sharing storage with the stream
+    BufferList read_buffer(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -0,0 +1,235 @@
+#include "congestion_control.hh"
+
+#include <cmath>
+#include <iterator>
+
+using namespace std;
+
+void NewReno::on_ack(const size_t acked, const size_t, const uint64_t) {
+    if (in_slow_start()) {
+        _cwnd += std::min(acked, mss);
+        return;
+    }
+    // congestion avoidance: one segment more per window's worth of acknowledged bytes
+    bytesAcked += acked;
+    if (bytesAcked >= _cwnd) {
+        bytesAcked -= _cwnd;
+        _cwnd += mss;
+    }
+}
+
+void NewReno::on_loss(const size_t in_flight, const uint64_t) {
+    _ssthresh = std::max(in_flight / 2, 2 * mss);
+    _cwnd = _ssthresh;
+    bytesAcked = 0;
+}
+
+void NewReno::on_rto(const size_t in_flight, const uint64_t) {
+    _ssthresh = std::max(in_flight / 2, 2 * mss);
+    _cwnd = mss;
+    bytesAcked = 0;
+}
+
+void Cubic::on_ack(const size_t acked, const size_t, const uint64_t now) {
+    if (in_slow_start()) {
+        _cwnd += std::min(acked, mss);
+        return;
+    }
+    const double cwnd = double(_cwnd) / mss;
+    if (!inEpoch) {
+        inEpoch = true;
+        epochStart = now;
+        if (cwnd < wMax) {
+            k = cbrt((wMax - cwnd) / C);
+        } else {
+            k = 0;
+            wMax = cwnd;
+        }
+        wEst = cwnd;
+    }
+    const double t = double(now - epochStart) / 1000;
+    double target = C * (t - k) * (t - k) * (t - k) + wMax;
+
+    // stay at least as aggressive as standard TCP would have been (the "TCP-friendly region")
+    wEst += 3 * (1 - BETA) / (1 + BETA) * (double(acked) / mss) / cwnd;
+    target = std::min(std::max(target, wEst), 1.5 * cwnd);
+
+    if (target > cwnd) {
+        _cwnd += static_cast<size_t>((target - cwnd) / cwnd * acked);
+    }
+}
+
+void Cubic::reduce() {
+    const double cwnd = double(_cwnd) / mss;
+    // fast convergence: release bandwidth sooner if the last reduction came at a smaller window
+    wMax = cwnd < wLastMax ? cwnd * (1 + BETA) / 2 : cwnd;
+    wLastMax = cwnd;
+    _ssthresh = std::max(static_cast<size_t>(_cwnd * BETA), 2 * mss);
+    inEpoch = false;
+}
+
+void Cubic::on_loss(const size_t, const uint64_t) {
+    reduce();
+    _cwnd = _ssthresh;
+}
+
+void Cubic::on_rto(const size_t, const uint64_t) {
+    reduce();
+    _cwnd = mss;
+}
+
+size_t Bbr::bdp(const double gain) const {
+    if (!_minRtt || bwFilter.empty()) {
+        return initial_window(mss);
+    }
+    return static_cast<size_t>(gain * bottleneck_bandwidth() * double(std::max<uint64_t>(*_minRtt, 1)));
+}
+
+void Bbr::updateBandwidth(const RateSample &sample) {
+    roundStart = sample.prior_delivered >= nextRoundDelivered;
+    if (roundStart) {
+        nextRoundDelivered = sample.delivered;
+        ++round;
+    }
+    while (!bwFilter.empty() && bwFilter.front().first + BW_WINDOW <= round) {
+        bwFilter.pop_front();
+    }
+    const double bw = sample.delivery_rate();
+    if (bw <= 0) {
+        return;
+    }
+    // keep only the samples that a later, larger one doesn't already beat
+    while (!bwFilter.empty() && bwFilter.back().second <= bw) {
+        bwFilter.pop_back();
+    }
+    bwFilter.emplace_back(round, bw);
+}
+
+void Bbr::enterProbeBw(const uint64_t now) {
+    _mode = Mode::ProbeBw;
+    cwndGain = CWND_GAIN;
+    // start past the probing phase, so that the first thing PROBE_BW does isn't to queue again
+    cycleIndex = 2;
+    cycleStamp = now;
+    lossInCycle = false;
+    pacingGain = PROBE_BW_GAINS[cycleIndex];
+}
+
+void Bbr::updateMode(const RateSample &sample, const uint64_t now) {
+    // the pipe is full once three rounds in a row fail to raise the bandwidth by a quarter
+    if (!filledPipe && roundStart && !bwFilter.empty()) {
+        if (bottleneck_bandwidth() >= 1.25 * fullBw) {
+            fullBw = bottleneck_bandwidth();
+            fullBwRounds = 0;
+        } else if (++fullBwRounds >= 3) {
+            filledPipe = true;
+        }
+    }
+    if (_mode == Mode::Startup && filledPipe) {
+        _mode = Mode::Drain;
+        pacingGain = 1 / HIGH_GAIN;
+        cwndGain = HIGH_GAIN;
+    }
+    if (_mode == Mode::Drain && sample.in_flight <= bdp(1)) {
+        enterProbeBw(now);
+    }
+    if (_mode == Mode::ProbeBw) {
+        bool next = _minRtt && now - cycleStamp > *_minRtt;
+        if (pacingGain > 1) {
+            // probe until the extra data is queued, or something is lost
+            next = next && (lossInCycle || sample.in_flight >= bdp(pacingGain));
+        } else if (pacingGain < 1) {
+            // drain until the queue the probe built is gone
+            next = next || sample.in_flight <= bdp(1);
+        }
+        if (next) {
+            cycleIndex = (cycleIndex + 1) % std::size(PROBE_BW_GAINS);
+            cycleStamp = now;
+            lossInCycle = false;
+            pacingGain = PROBE_BW_GAINS[cycleIndex];
+        }
+    }
+}
+
+void Bbr::on_rate_sample(const RateSample &sample, const uint64_t now) {
+    updateBandwidth(sample);
+
+    const bool minRttExpired = _minRtt && now > minRttStamp + MIN_RTT_WINDOW;
+    if (sample.rtt && (!_minRtt || *sample.rtt <= *_minRtt || minRttExpired)) {
+        _minRtt = sample.rtt;
+        minRttStamp = now;
+    }
+
+    updateMode(sample, now);
+
+    if (minRttExpired && _mode != Mode::ProbeRtt) {
+        _mode = Mode::ProbeRtt;
+        pacingGain = cwndGain = 1;
+        priorCwnd = _cwnd;
+        probeRttDone.reset();
+    }
+    if (_mode == Mode::ProbeRtt) {
+        if (!probeRttDone && sample.in_flight <= 4 * mss) {
+            probeRttDone = now + PROBE_RTT_TIME;
+            probeRttRound = round;
+        } else if (probeRttDone && now >= *probeRttDone && round > probeRttRound) {
+            minRttStamp = now;
+            _cwnd = std::max(_cwnd, priorCwnd);
+            if (filledPipe) {
+                enterProbeBw(now);
+            } else {
+                _mode = Mode::Startup;
+                pacingGain = cwndGain = HIGH_GAIN;
+            }
+        }
+    }
+
+    double rate = pacingGain * bottleneck_bandwidth();
+    if (bwFilter.empty() && _minRtt) {
+        // until the first bandwidth sample, pace the initial window over the first RTT
+        rate = HIGH_GAIN * double(_cwnd) / double(std::max<uint64_t>(*_minRtt, 1));
+    }
+    // in STARTUP, a lull in delivery mustn't slow the sender down
+    if (filledPipe || rate > _pacingRate) {
+        _pacingRate = rate;
+    }
+
+    const auto target = bdp(cwndGain) + 3 * mss;
+    if (filledPipe) {
+        _cwnd = std::min(_cwnd + sample.acked, target);
+    } else if (_cwnd < target || sample.delivered < initial_window(mss)) {
+        _cwnd += sample.acked;
+    }
+    _cwnd = std::max(_cwnd, 4 * mss);
+    if (_mode == Mode::ProbeRtt) {
+        _cwnd = std::min(_cwnd, 4 * mss);
+    }
+}
+
+void Bbr::on_loss(const size_t, const uint64_t) { lossInCycle = true; }
+
+void Bbr::on_rto(const size_t, const uint64_t) {
+    // the model stands, but whatever was in flight is presumed gone
+    lossInCycle = true;
+    _cwnd = mss;
+}
+
+optional<double> Bbr::pacing_rate() const {
+    if (_pacingRate <= 0) {
+        return {};
+    }
+    return _pacingRate;
+}
+
+unique_ptr<CongestionControl> make_congestion_control(const CongestionAlgorithm algorithm, const size_t mss) {
+    switch (algorithm) {
+        case CongestionAlgorithm::NewReno:
+            return make_unique<NewReno>(mss);
+        case CongestionAlgorithm::Cubic:
+            return make_unique<Cubic>(mss);
+        case CongestionAlgorithm::Bbr:
+            return make_unique<Bbr>(mss);
+        default:
+            return nullptr;
+    }
+}
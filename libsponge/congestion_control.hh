@@ -0,0 +1,203 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+
+//! The congestion control algorithms a TCPSender can run
+enum class CongestionAlgorithm : uint8_t {
+    None,     //!< no congestion window: send whatever the receiver's window allows
+    NewReno,  //!< slow start and additive increase, halving on loss ([RFC 5681](\ref rfc::rfc5681))
+    Cubic,    //!< window growth as a cubic function of the time since the last loss ([RFC 8312](\ref rfc::rfc8312))
+    Bbr,      //!< a model of the path's bandwidth and round-trip time, after BBR (v1)
+};
+
+//! \brief What an ACK says about the rate at which the path delivers data
+
+//! Taken from the most recently sent segment the ACK acknowledges or SACKs: the bytes delivered
+//! since that segment was sent, over the time they took.
+struct RateSample {
+    uint64_t delivered;           //!< bytes acknowledged or SACKed so far
+    uint64_t prior_delivered;     //!< bytes acknowledged or SACKed when the segment was sent
+    uint64_t interval;            //!< milliseconds between then and now
+    size_t acked;                 //!< bytes this ACK acknowledged or SACKed
+    size_t in_flight;             //!< bytes still outstanding after this ACK
+    std::optional<uint64_t> rtt;  //!< the segment's round-trip time, unless it was retransmitted
+
+    //! \returns the delivery rate, in bytes per millisecond
+    double delivery_rate() const { return interval ? double(delivered - prior_delivered) / double(interval) : 0; }
+};
+
+//! \brief The interface between a TCPSender and its congestion control algorithm
+
+//! The sender reports what happens to its segments through the hooks, and never sends more
+//! than cwnd() bytes of sequence space that are not yet acknowledged. All sizes are in bytes
+//! and all times in milliseconds of the sender's clock (the sum of its ticks).
+class CongestionControl {
+  protected:
+    size_t mss;  //!< the sender's maximum segment size
+    size_t _cwnd;
+    size_t _ssthresh = SIZE_MAX;
+
+  public:
+    //! The initial window from [RFC 3390](\ref rfc::rfc3390)
+    static size_t initial_window(const size_t mss) { return std::min(4 * mss, std::max<size_t>(2 * mss, 4380)); }
+
+    explicit CongestionControl(const size_t mss_) : mss(mss_), _cwnd(initial_window(mss_)) {}
+    virtual ~CongestionControl() = default;
+
+    //! \returns the congestion window
+    size_t cwnd() const { return _cwnd; }
+
+    //! \returns the slow start threshold
+    size_t ssthresh() const { return _ssthresh; }
+
+    //! \brief The peer's SYN lowered the sender's MSS, before any data was sent
+    void set_mss(const size_t mss_) {
+        mss = mss_;
+        _cwnd = initial_window(mss_);
+    }
+
+    //! \returns `true` while the window grows exponentially
+    bool in_slow_start() const { return _cwnd < _ssthresh; }
+
+    //! \brief `acked` bytes of new data were acknowledged
+    //! \param[in] in_flight is what was still outstanding before the acknowledgment
+    virtual void on_ack(const size_t acked, const size_t in_flight, const uint64_t now) = 0;
+
+    //! \brief A segment was found lost while later ones were still getting through (e.g. duplicate ACKs)
+    virtual void on_loss(const size_t in_flight, const uint64_t now) = 0;
+
+    //! \brief The retransmission timer expired
+    virtual void on_rto(const size_t in_flight, const uint64_t now) = 0;
+
+    //! \brief An ACK acknowledged or SACKed new data, even during loss recovery (unlike on_ack)
+    virtual void on_rate_sample(const RateSample &, const uint64_t) {}
+
+    //! \returns the rate, in bytes per millisecond, at which the sender must pace, if the algorithm sets it
+    virtual std::optional<double> pacing_rate() const { return {}; }
+};
+
+//! \brief NewReno congestion control ([RFC 5681](\ref rfc::rfc5681), [RFC 6582](\ref rfc::rfc6582))
+class NewReno : public CongestionControl {
+    size_t bytesAcked{0};  //!< acknowledged bytes not yet turned into window growth in congestion avoidance
+
+  public:
+    using CongestionControl::CongestionControl;
+
+    void on_ack(const size_t acked, const size_t in_flight, const uint64_t now) override;
+    void on_loss(const size_t in_flight, const uint64_t now) override;
+    void on_rto(const size_t in_flight, const uint64_t now) override;
+};
+
+//! \brief CUBIC congestion control ([RFC 8312](\ref rfc::rfc8312))
+
+//! Windows are tracked in units of segments, as in the RFC, and converted to bytes for cwnd().
+class Cubic : public CongestionControl {
+    static constexpr double C = 0.4;
+    static constexpr double BETA = 0.7;
+
+    double wMax{0};      //!< the window just before the last reduction
+    double wLastMax{0};  //!< wMax before the last reduction, for fast convergence
+    double wEst{0};      //!< the window standard TCP would have reached in this epoch
+    double k{0};         //!< the time, in seconds, to grow back to wMax
+    bool inEpoch{false};
+    uint64_t epochStart{0};
+
+    void reduce();
+
+  public:
+    using CongestionControl::CongestionControl;
+
+    void on_ack(const size_t acked, const size_t in_flight, const uint64_t now) override;
+    void on_loss(const size_t in_flight, const uint64_t now) override;
+    void on_rto(const size_t in_flight, const uint64_t now) override;
+};
+
+//! \brief Congestion control from a model of the path, after BBR (v1)
+
+//! The model is the bottleneck bandwidth, the most recent ten rounds' highest delivery rate, and the
+//! round-trip propagation time, the lowest RTT of the last ten seconds. The sender paces at a gain times
+//! the bandwidth and keeps at most twice their product (the BDP) in flight. Losses don't shrink the window.
+//! The gains follow the phase:
+//! - STARTUP: grow the rate by 2/ln 2 per round until the bandwidth stops growing by 25% for three rounds;
+//! - DRAIN: pace below the bandwidth until the queue STARTUP built is gone;
+//! - PROBE_BW: cycle through gains of 5/4, 3/4, then six rounds of 1, to probe for more bandwidth and
+//!   then drain what the probe queued;
+//! - PROBE_RTT: if the minimum RTT hasn't been seen again in ten seconds, hold four segments in
+//!   flight for 200 ms to let the queue empty and measure it afresh.
+//!
+//! \note Unlike BBR proper, no rate sample is discounted as application-limited: the sender is
+//! assumed to always have data to send.
+class Bbr : public CongestionControl {
+  public:
+    enum class Mode : uint8_t { Startup, Drain, ProbeBw, ProbeRtt };
+
+  private:
+    static constexpr double HIGH_GAIN = 2.885;  //!< 2/ln 2, the smallest gain that doubles delivery each round
+    static constexpr double CWND_GAIN = 2;
+    static constexpr uint64_t BW_WINDOW = 10;          //!< rounds in the bandwidth filter
+    static constexpr uint64_t MIN_RTT_WINDOW = 10000;  //!< milliseconds in the min RTT filter
+    static constexpr uint64_t PROBE_RTT_TIME = 200;    //!< milliseconds spent in PROBE_RTT
+    static constexpr double PROBE_BW_GAINS[] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+
+    Mode _mode{Mode::Startup};
+    double pacingGain{HIGH_GAIN};
+    double cwndGain{HIGH_GAIN};
+
+    //! the rounds and delivery rates that may yet be the maximum of the window, both decreasing
+    std::deque<std::pair<uint64_t, double>> bwFilter{};
+    double _pacingRate{0};
+    std::optional<uint64_t> _minRtt{};
+    uint64_t minRttStamp{0};
+
+    uint64_t round{0};
+    uint64_t nextRoundDelivered{0};
+    bool roundStart{false};
+
+    bool filledPipe{false};
+    double fullBw{0};
+    unsigned fullBwRounds{0};
+
+    size_t cycleIndex{0};
+    uint64_t cycleStamp{0};
+    bool lossInCycle{false};
+
+    size_t priorCwnd{0};  //!< the window before PROBE_RTT, to return to
+    std::optional<uint64_t> probeRttDone{};
+    uint64_t probeRttRound{0};
+
+    //! \returns `gain` times the estimated BDP, in bytes
+    size_t bdp(const double gain) const;
+    void updateBandwidth(const RateSample &sample);
+    void updateMode(const RateSample &sample, const uint64_t now);
+    void enterProbeBw(const uint64_t now);
+
+  public:
+    using CongestionControl::CongestionControl;
+
+    void on_ack(const size_t, const size_t, const uint64_t) override {}
+    void on_loss(const size_t in_flight, const uint64_t now) override;
+    void on_rto(const size_t in_flight, const uint64_t now) override;
+    void on_rate_sample(const RateSample &sample, const uint64_t now) override;
+    std::optional<double> pacing_rate() const override;
+
+    //! \returns the phase the model is in
+    Mode mode() const { return _mode; }
+
+    //! \returns the estimated bottleneck bandwidth, in bytes per millisecond
+    double bottleneck_bandwidth() const { return bwFilter.empty() ? 0 : bwFilter.front().second; }
+
+    //! \returns the estimated round-trip propagation time, in milliseconds
+    std::optional<uint64_t> min_rtt() const { return _minRtt; }
+};
+
+//! \returns a controller running `algorithm`, or nullptr for CongestionAlgorithm::None
+std::unique_ptr<CongestionControl> make_congestion_control(const CongestionAlgorithm algorithm, const size_t mss);
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
@@ -78,6 +78,7 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
         }
 
         auto iter = arpMap.find(arp.sender_ip_address);
+        expiries.emplace(time + PERIOD, arp.sender_ip_address);
         if (iter == arpMap.end()) {
             arpMap[arp.sender_ip_address] = ArpEntry(arp.sender_ethernet_address, time + PERIOD);
         } else {
@@ -124,7 +125,26 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
-void NetworkInterface::tick(const size_t ms_since_last_tick) { time += ms_since_last_tick; }
+void NetworkInterface::tick(const size_t ms_since_last_tick) {
+    time += ms_since_last_tick;
+    while (!expiries.empty() && expiries.front().first < time) {
+        const auto [expiration, ip] = expiries.front();
+        expiries.pop();
+        // a mapping learned again since, or waiting on a new request, stays
+        const auto iter = arpMap.find(ip);
+        if (iter != arpMap.end() && iter->second.expiration == expiration && iter->second.wait.empty()) {
+            arpMap.erase(iter);
+        }
+    }
+}
+
+optional<uint64_t> NetworkInterface::next_timer() const {
+    if (expiries.empty()) {
+        return {};
+    }
+    return expiries.front().first + 1 - time;
+}
+
 void NetworkInterface::sendArp(const uint32_t ip, ArpEntry &entry) {
     if (time < entry.requestTime + ARPPENDING) {
         return;
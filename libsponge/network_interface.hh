@@ -12,6 +12,7 @@
 #include <optional>
 #include <queue>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 //! \brief A "network interface" that connects IP (the internet layer, or network layer)
@@ -55,6 +56,8 @@ class NetworkInterface {
         bool valid() { return addr != ETHERNET_BROADCAST; }
     };
     std::unordered_map<uint32_t, ArpEntry> arpMap;
+    //! the expirations of learned mappings and their IPs, oldest first, for tick() to forget them
+    std::queue<std::pair<uint64_t, uint32_t>> expiries{};
     uint64_t time = ARPPENDING;
     static constexpr uint64_t PERIOD = 1000 * 30;
     static constexpr uint64_t ARPPENDING = 5000;
@@ -81,6 +84,10 @@ class NetworkInterface {
 
     //! \brief Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Milliseconds until a tick() would forget a mapping, or nothing if none is learned
+    std::optional<uint64_t> next_timer() const;
+
     void sendArp(const uint32_t ip, ArpEntry &entry);
 };
 
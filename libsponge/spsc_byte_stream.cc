@@ -0,0 +1,140 @@
+#include "spsc_byte_stream.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+
+using namespace std;
+
+// The writer publishes writerSeq and then looks at readerParked; a reader that is about to
+// sleep publishes readerParked and then looks at writerSeq. Both store-then-load pairs are
+// sequentially consistent, so at least one side always sees the other's update: either the
+// writer notices that the reader has parked and signals `readable`, or the reader notices the
+// new bytes and doesn't go to sleep (and symmetrically for `writable`).
+
+SpscByteStream::SpscByteStream(const size_t cap)
+    : buf(cap)
+    , capacity(cap)
+    , readable(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)))
+    , writable(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {}
+
+void SpscByteStream::signal(FileDescriptor &fd) { SystemCall("eventfd_write", ::eventfd_write(fd.fd_num(), 1)); }
+
+void SpscByteStream::drain(FileDescriptor &fd) {
+    eventfd_t value;
+    SystemCall("eventfd_read", ::eventfd_read(fd.fd_num(), &value), EAGAIN);
+}
+
+void SpscByteStream::wait(FileDescriptor &fd) {
+    pollfd pfd{fd.fd_num(), POLLIN, 0};
+    SystemCall("poll", ::poll(&pfd, 1, -1), EINTR);
+    drain(fd);
+}
+
+size_t SpscByteStream::write(string_view data) {
+    const auto w = writerSeq.load(memory_order_relaxed);
+    const auto r = readerSeq.load(memory_order_acquire);
+    const auto res = std::min(capacity - (w - r), data.size());
+    if (res == 0) {
+        return 0;
+    }
+    const auto prod = w % capacity;
+    const auto part1 = std::min(capacity - prod, res);
+    memcpy(&buf[prod], data.data(), part1);
+    memcpy(buf.data(), data.data() + part1, res - part1);
+
+    writerSeq.store(w + res, memory_order_seq_cst);
+    if (readerParked.load(memory_order_seq_cst) && readerParked.exchange(false, memory_order_seq_cst)) {
+        signal(readable);
+    }
+    return res;
+}
+
+size_t SpscByteStream::remaining_capacity() const { return capacity - buffer_size(); }
+
+void SpscByteStream::wait_writable() {
+    while (park_writer()) {
+        wait(writable);
+    }
+}
+
+bool SpscByteStream::park_writer() {
+    writerParked.store(true, memory_order_seq_cst);
+    if (remaining_capacity() == 0 && !error()) {
+        return true;
+    }
+    writerParked.store(false, memory_order_relaxed);
+    return false;
+}
+
+void SpscByteStream::end_input() {
+    flag.fetch_or(WRITEEND, memory_order_release);
+    signal(readable);
+}
+
+void SpscByteStream::set_error() {
+    flag.fetch_or(ERROR, memory_order_release);
+    signal(readable);
+    signal(writable);
+}
+
+//! \param[in] len bytes will be copied from the output side of the buffer
+string SpscByteStream::peek_output(const size_t len) const {
+    const auto r = readerSeq.load(memory_order_relaxed);
+    const auto w = writerSeq.load(memory_order_acquire);
+    const auto res = std::min(w - r, len);
+    string ret(res, 0);
+    const auto conm = r % capacity;
+    const auto part1 = std::min(capacity - conm, res);
+    memcpy(ret.data(), &buf[conm], part1);
+    memcpy(ret.data() + part1, buf.data(), res - part1);
+    return ret;
+}
+
+//! \param[in] len bytes will be removed from the output side of the buffer
+void SpscByteStream::pop_output(const size_t len) {
+    const auto r = readerSeq.load(memory_order_relaxed);
+    if (len > writerSeq.load(memory_order_acquire) - r) {
+        throw runtime_error("Remove error");
+    }
+    if (len == 0) {
+        return;
+    }
+    readerSeq.store(r + len, memory_order_seq_cst);
+    if (writerParked.load(memory_order_seq_cst) && writerParked.exchange(false, memory_order_seq_cst)) {
+        signal(writable);
+    }
+}
+
+//! \param[in] len bytes will be popped and returned
+//! \returns a string
+string SpscByteStream::read(const size_t len) {
+    auto res = peek_output(len);
+    pop_output(res.size());
+    return res;
+}
+
+void SpscByteStream::wait_readable() {
+    while (park_reader()) {
+        wait(readable);
+    }
+}
+
+bool SpscByteStream::park_reader() {
+    readerParked.store(true, memory_order_seq_cst);
+    if (buffer_empty() && !input_ended() && !error()) {
+        return true;
+    }
+    readerParked.store(false, memory_order_relaxed);
+    return false;
+}
+
+size_t SpscByteStream::buffer_size() const {
+    const auto r = readerSeq.load(memory_order_seq_cst);
+    return writerSeq.load(memory_order_seq_cst) - r;
+}
@@ -0,0 +1,146 @@
+#ifndef SPONGE_LIBSPONGE_SPSC_BYTE_STREAM_HH
+#define SPONGE_LIBSPONGE_SPSC_BYTE_STREAM_HH
+
+#include "file_descriptor.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! \brief An in-order byte stream shared by exactly one writer thread and one reader thread.
+
+//! Behaves like ByteStream, but the writer and the reader may run on different threads
+//! without a lock: each side only ever advances its own sequence number (published with
+//! release semantics and observed with acquire semantics), so moving bytes between the
+//! threads costs one memcpy in and one memcpy out.
+//!
+//! A side that finds the stream empty (or full) can sleep on readable_fd() (or
+//! writable_fd()), which are [eventfd(2)](\ref man2::eventfd) descriptors suitable for
+//! an EventLoop rule, once park_reader() (or park_writer()) says it may. They are only
+//! signalled for a side that has parked, so while the reader keeps up with the writer,
+//! moving bytes makes no system calls.
+class SpscByteStream {
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<uint8_t> buf;
+    const size_t capacity;
+
+    //! written only by the writer thread
+    alignas(CACHE_LINE) std::atomic<size_t> writerSeq{0};
+    //! written only by the reader thread
+    alignas(CACHE_LINE) std::atomic<size_t> readerSeq{0};
+
+    alignas(CACHE_LINE) std::atomic<uint8_t> flag{0};
+    std::atomic<bool> readerParked{false};  //!< is the reader about to sleep on `readable`?
+    std::atomic<bool> writerParked{false};  //!< is the writer about to sleep on `writable`?
+    enum Flag : uint8_t {
+        ERROR = 1 << 0,
+        WRITEEND = 1 << 1,
+    };
+
+    FileDescriptor readable;  //!< signalled when bytes (or the end of input) become available
+    FileDescriptor writable;  //!< signalled when space becomes available
+
+    static void signal(FileDescriptor &fd);
+    static void drain(FileDescriptor &fd);
+    static void wait(FileDescriptor &fd);
+
+  public:
+    //! Construct a stream with room for `capacity` bytes.
+    explicit SpscByteStream(const size_t cap);
+
+    //! \name "Input" interface for the writer thread
+    //!@{
+
+    //! Write a string of bytes into the stream. Write as many
+    //! as will fit, and return how many were written.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string_view data);
+
+    //! \returns the number of additional bytes that the stream has space for
+    size_t remaining_capacity() const;
+
+    //! Block until the stream has space for at least one byte (or has suffered an error)
+    void wait_writable();
+
+    //! \brief Announce that the writer is about to sleep on writable_fd()
+    //! \returns `false` if the stream has space (or has suffered an error) after all, and it shouldn't
+    bool park_writer();
+
+    //! Signal that the byte stream has reached its ending
+    void end_input();
+
+    //! \returns an eventfd that becomes readable when space may have become available
+    FileDescriptor &writable_fd() { return writable; }
+    //!@}
+
+    //! Indicate that the stream suffered an error (either thread may call this)
+    void set_error();
+
+    //! \name "Output" interface for the reader thread
+    //!@{
+
+    //! Peek at next "len" bytes of the stream
+    //! \returns a string
+    std::string peek_output(const size_t len) const;
+
+    //! Remove bytes from the buffer
+    void pop_output(const size_t len);
+
+    //! Read (i.e., copy and then pop) the next "len" bytes of the stream
+    //! \returns a string
+    std::string read(const size_t len);
+
+    //! Block until the stream has bytes to read (or has ended or suffered an error)
+    void wait_readable();
+
+    //! \brief Announce that the reader is about to sleep on readable_fd()
+    //! \returns `false` if the stream has bytes (or has ended or suffered an error) after all, and it shouldn't
+    bool park_reader();
+
+    //! \returns an eventfd that becomes readable when bytes may have become available
+    FileDescriptor &readable_fd() { return readable; }
+
+    //! \returns `true` if the stream input has ended
+    bool input_ended() const { return flag.load(std::memory_order_acquire) & WRITEEND; }
+
+    //! \returns `true` if the stream has suffered an error
+    bool error() const { return flag.load(std::memory_order_acquire) & ERROR; }
+
+    //! \returns the maximum amount that can currently be read from the stream
+    size_t buffer_size() const;
+
+    //! \returns `true` if the buffer is empty
+    bool buffer_empty() const { return buffer_size() == 0; }
+
+    //! \returns `true` if the output has reached the ending
+    bool eof() const { return input_ended() && buffer_empty(); }
+    //!@}
+
+    //! \name General accounting
+    //!@{
+
+    //! Total number of bytes written
+    size_t bytes_written() const { return writerSeq.load(std::memory_order_acquire); }
+
+    //! Total number of bytes popped
+    size_t bytes_read() const { return readerSeq.load(std::memory_order_acquire); }
+    //!@}
+
+    //! \name
+    //! The stream is shared by reference between its two threads, so it cannot be moved or copied
+
+    //!@{
+    SpscByteStream(const SpscByteStream &) = delete;
+    SpscByteStream(SpscByteStream &&) = delete;
+    SpscByteStream &operator=(const SpscByteStream &) = delete;
+    SpscByteStream &operator=(SpscByteStream &&) = delete;
+    ~SpscByteStream() = default;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_SPSC_BYTE_STREAM_HH
@@ -1,6 +1,9 @@
 #include "stream_reassembler.hh"
 
+#include "tcp_config.hh"
+
 #include <algorithm>
+#include <cstring>
 
 // Dummy implementation of a stream reassembler.
 
@@ -11,12 +14,58 @@
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity) : queue(), _output(capacity), _capacity(capacity) {}
+//! \returns how many out-of-order runs to make room for: one per full-sized segment in the window
+static size_t expectedRuns(const size_t capacity) { return capacity / TCPConfig::MAX_PAYLOAD_SIZE + 1; }
+
+//! \param[in] mode how the output holds the assembled bytes: ByteStream::Mode::Ring or ByteStream::Mode::Mirrored
+StreamReassembler::StreamReassembler(const size_t capacity, const Backend backend_, const ByteStream::Mode mode)
+    : queue()
+    , intervals(backend_ == Backend::Ring ? expectedRuns(capacity) : 0)
+    , _output(capacity, mode)
+    , _capacity(capacity)
+    , backend(backend_) {
+    if (backend == Backend::Slab) {
+        slab.emplace(capacity, expectedRuns(capacity));
+    }
+}
+
+//! \details The window grows with the capacity: the bytes stored out of order stay where they
+//! are in the stream, whatever the backend.
+void StreamReassembler::grow(const size_t capacity) {
+    if (capacity <= _capacity) {
+        return;
+    }
+    _capacity = capacity;
+    _output.grow(capacity);
+    if (slab) {
+        slab->grow(capacity);
+    }
+}
+
+size_t StreamReassembler::footprint(const size_t capacity) const {
+    return _output.footprint(capacity) + (slab ? slab->footprint(capacity) : 0);
+}
+
+void StreamReassembler::push_substring(const string &data, const uint64_t index, const bool eof) {
+    push_substring(string_view(data), index, eof);
+}
+
+void StreamReassembler::push_substring(const Buffer &data, const uint64_t index, const bool eof) {
+    push_substring(data.str(), index, eof);
+}
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
-void StreamReassembler::push_substring(const string &data, size_t index, bool eof) {
+void StreamReassembler::push_substring(string_view data, uint64_t index, bool eof) {
+    if (backend == Backend::Ring) {
+        pushRing(data, index, eof);
+        return;
+    }
+    if (backend == Backend::Slab) {
+        pushSlab(data, index, eof);
+        return;
+    }
     auto packetBound = index + data.size();
     if (packetBound < seq) {
         return;
@@ -31,36 +80,183 @@ void StreamReassembler::push_substring(const string &data, size_t index, bool eo
     if (maxSeq <= index) {
         return;
     }
-    auto beg = data.cbegin();
-    auto end = data.cend();
     if (packetBound > maxSeq) {
-        end -= packetBound - maxSeq;
+        data.remove_suffix(packetBound - maxSeq);
         eof = false;
     }
-    size_t pos = 0;
     if (index < seq) {
-        pos = seq - index;
-        beg += pos;
+        data.remove_prefix(seq - index);
         index = seq;
     }
-    string message(beg, end);
-    queue.push(index, message, eof);
-    auto top = queue.topSeq();
-    if (top == seq) {
-        auto item = queue.pop();
-        seq += _output.write(item.buffer);
+    if (data.empty()) {
+        // an empty eof segment ahead of the stream: remember where it ends rather than queueing nothing
+        if (eof) {
+            eofIndex = index;
+        }
+        return;
+    }
+    if (index == seq && (queue.empty() || queue.topSeq() > index + data.size())) {
+        // in order, and not touching anything queued: straight into the output
+        const auto written = writeContiguous(data);
+        if (written < data.size()) {
+            queue.push(seq, data.substr(written), eof);
+        } else if (eof || eofIndex == seq) {
+            _output.end_input();
+        }
+        return;
+    }
+    queue.push(index, data, eof);
+    drain();
+}
+
+//! \details Writes every queued run that starts at the end of the output. If the output
+//! pushes back, the unwritten tail is queued again, to be written by a later push.
+void StreamReassembler::drain() {
+    while (!queue.empty() && queue.topSeq() == seq) {
+        const auto item = queue.pop();
+        const auto written = writeContiguous(item.buffer);
+        if (written < item.buffer.size()) {
+            queue.push(seq, string_view(item.buffer).substr(written), item.eof);
+            return;
+        }
         if (item.eof) {
             _output.end_input();
+            return;
         }
     }
+    if (eofIndex == seq) {
+        _output.end_input();
+    }
+}
+
+size_t StreamReassembler::writeContiguous(string_view data) {
+    const auto written = std::min(data.size(), _output.remaining_capacity());
+    copyIntoWindow(data.substr(0, written), 0);
+    _output.commit_write(written);
+    seq += written;
+    return written;
+}
+
+//! \details The window the reassembler may hold, [seq, bytes_read() + capacity), is exactly
+//! the free space of the output stream, so every byte is copied once: straight to the place
+//! in the ring where it will be read from. Becoming contiguous only moves the write cursor.
+void StreamReassembler::pushRing(string_view data, uint64_t index, const bool eof) {
+    const uint64_t maxSeq = _output.bytes_read() + _capacity;
+    const uint64_t packetBound = index + data.size();
+    if (eof && packetBound <= maxSeq) {
+        eofIndex = packetBound;
+    }
+    if (!data.empty() && packetBound > seq && index < maxSeq) {
+        if (packetBound > maxSeq) {
+            data.remove_suffix(packetBound - maxSeq);
+        }
+        if (index < seq) {
+            data.remove_prefix(seq - index);
+            index = seq;
+        }
+        copyIntoWindow(data, index - seq);
+        const uint64_t bound = index + data.size();
+        if (index == seq && (intervals.empty() || intervals.front().begin > bound)) {
+            // in order, and not touching anything queued: nothing to track
+            _output.commit_write(data.size());
+            seq = bound;
+        } else {
+            intervals.insert(index, bound);
+        }
+    }
+    const auto end = intervals.popFrom(seq);
+    if (end != seq) {
+        _output.commit_write(end - seq);
+        seq = end;
+    }
+    if (eofIndex == seq) {
+        _output.end_input();
+    }
+}
+
+//! \details Like pushRing(), but the out-of-order bytes wait in the slab rather than in the output,
+//! which only ever receives contiguous bytes.
+void StreamReassembler::pushSlab(string_view data, uint64_t index, const bool eof) {
+    const uint64_t maxSeq = _output.bytes_read() + _capacity;
+    const uint64_t packetBound = index + data.size();
+    if (eof && packetBound <= maxSeq) {
+        eofIndex = packetBound;
+    }
+    if (!data.empty() && packetBound > seq && index < maxSeq) {
+        if (packetBound > maxSeq) {
+            data.remove_suffix(packetBound - maxSeq);
+        }
+        if (index < seq) {
+            data.remove_prefix(seq - index);
+            index = seq;
+        }
+        const auto &runs = slab->runs();
+        if (index == seq && (runs.empty() || runs.front().begin > index + data.size())) {
+            // in order, and not touching anything stored: straight into the output
+            const auto written = writeContiguous(data);
+            data.remove_prefix(written);
+            index += written;
+        }
+        if (!data.empty()) {
+            slab->push(index, data);
+        }
+    }
+    drainSlab();
+}
+
+void StreamReassembler::drainSlab() {
+    const auto end = slab->popFrom(seq);
+    for (const auto view : slab->view(seq, end)) {
+        if (writeContiguous(view) < view.size()) {
+            // the output pushed back: the rest stays in the slab
+            slab->restore(seq, end);
+            return;
+        }
+    }
+    if (eofIndex == seq) {
+        _output.end_input();
+    }
+}
+
+//! \param[in] offset is the distance from the assembled prefix to the first byte of `data`
+void StreamReassembler::copyIntoWindow(string_view data, size_t offset) {
+    for (const auto &span : _output.writable_spans()) {
+        if (offset >= span.iov_len) {
+            offset -= span.iov_len;
+            continue;
+        }
+        const auto part = std::min(span.iov_len - offset, data.size());
+        memcpy(static_cast<char *>(span.iov_base) + offset, data.data(), part);
+        data.remove_prefix(part);
+        offset = 0;
+    }
+}
+
+const OutOfOrderIntervals *StreamReassembler::outOfOrderRuns() const {
+    if (backend == Backend::Ring) {
+        return &intervals;
+    }
+    return slab ? &slab->runs() : nullptr;
 }
 
 size_t StreamReassembler::unassembled_bytes() const {
-    size_t size = 0;
-    for (auto &i : queue.queue) {
-        size += i.second.buffer.size();
+    const auto *runs = outOfOrderRuns();
+    return runs ? runs->size() : queue.size();
+}
+
+size_t StreamReassembler::unassembled_holes() const {
+    const auto *runs = outOfOrderRuns();
+    return runs ? runs->runs() : queue.holes();
+}
+
+uint64_t StreamReassembler::contiguous_end() const {
+    if (const auto *runs = outOfOrderRuns()) {
+        return runs->empty() ? seq : runs->front().end;
     }
-    return size;
+    return queue.empty() ? seq : queue.contiguousEnd();
 }
 
-bool StreamReassembler::empty() const { return queue.queue.empty(); }
+bool StreamReassembler::empty() const {
+    const auto *runs = outOfOrderRuns();
+    return runs ? runs->empty() : queue.empty();
+}
@@ -4,10 +4,16 @@
 #include "byte_stream.hh"
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
+#include <iterator>
 #include <map>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 class XskTcpOutOfOrderQueue {
   public:
     struct OutOfOrderQueueElem {
@@ -19,14 +25,23 @@ class XskTcpOutOfOrderQueue {
             : buffer(std::move(elem.buffer)), eof(eof_) {}
         explicit OutOfOrderQueueElem(std::string &&buf, bool eof_) noexcept : buffer(std::move(buf)), eof(eof_) {}
     };
-    std::map<uint32_t, OutOfOrderQueueElem> queue{};
 
+  private:
+    std::map<uint64_t, OutOfOrderQueueElem> queue{};  //!< keyed by absolute stream index
+    size_t bytes{0};  //!< total size of the queued buffers, kept up to date by push() and pop()
+
+    void emplace(uint64_t idx, std::string &&buffer, bool eof) {
+        bytes += buffer.size();
+        queue.emplace(idx, OutOfOrderQueueElem(std::move(buffer), eof));
+    }
+
+  public:
     XskTcpOutOfOrderQueue() = default;
-    void push(uint32_t seq, const std::string &packet, bool eof) {
+    void push(uint64_t seq, std::string_view packet, bool eof) {
         const auto idx = seq;
-        auto buffer = packet;
+        std::string buffer(packet);
         if (queue.empty()) {
-            queue.emplace(idx, OutOfOrderQueueElem(std::move(buffer), eof));
+            emplace(idx, std::move(buffer), eof);
             return;
         }
         auto lowerBound = queue.lower_bound(idx);
@@ -46,10 +61,11 @@ class XskTcpOutOfOrderQueue {
                 memcpy(reinterpret_cast<uint8_t *>(&buffer[size]), &nextElem.buffer[bound - nextIdx], newSize - size);
                 eof = nextElem.eof;
             }
+            bytes -= nextElem.buffer.size();
             lowerBound = queue.erase(lowerBound);
         }
         if (queue.empty() || queue.begin() == lowerBound) {
-            queue.emplace(idx, OutOfOrderQueueElem(std::move(buffer), eof));
+            emplace(idx, std::move(buffer), eof);
             return;
         }
         --lowerBound;
@@ -58,7 +74,7 @@ class XskTcpOutOfOrderQueue {
             auto &prevElem = lowerBound->second;
             const auto prevBound = prevIdx + prevElem.buffer.size();
             if (prevBound < idx) {
-                queue.emplace(idx, OutOfOrderQueueElem(std::move(buffer), eof));
+                emplace(idx, std::move(buffer), eof);
                 return;
             }
             const auto bound = idx + buffer.size();
@@ -66,35 +82,225 @@ class XskTcpOutOfOrderQueue {
                 return;
             }
             auto newSize = bound - prevIdx;
+            bytes += newSize - prevElem.buffer.size();
             prevElem.buffer.resize(newSize);
             memcpy(&prevElem.buffer[idx - prevIdx], buffer.data(), buffer.size());
             prevElem.eof = eof;
         }
     }
-    [[nodiscard]] uint32_t topSeq() const { return queue.empty() ? -1 : queue.begin()->first; }
+    //! \returns the index of the first queued byte, or UINT64_MAX if nothing is queued
+    [[nodiscard]] uint64_t topSeq() const { return queue.empty() ? UINT64_MAX : queue.begin()->first; }
     OutOfOrderQueueElem pop() {
         auto beg = queue.begin();
         auto res = std::move(beg->second);
         queue.erase(beg);
+        bytes -= res.buffer.size();
         return res;
     }
+    [[nodiscard]] bool empty() const { return queue.empty(); }
+    //! \returns the number of bytes queued, in O(1)
+    [[nodiscard]] size_t size() const { return bytes; }
+    //! \returns the number of holes in front of queued bytes; the runs never touch, so there is one per run
+    [[nodiscard]] size_t holes() const { return queue.size(); }
+    //! \returns the end of the run at the front, i.e. how far the stream becomes contiguous once the
+    //! first hole is filled (or UINT64_MAX, like topSeq(), if nothing is queued)
+    [[nodiscard]] uint64_t contiguousEnd() const {
+        return queue.empty() ? UINT64_MAX : queue.begin()->first + queue.begin()->second.buffer.size();
+    }
+    //! Call `visit(begin, end)` on each queued run in order, until it returns `false`
+    template <typename F>
+    void forEachRun(F &&visit) const {
+        for (const auto &[idx, elem] : queue) {
+            if (!elem.buffer.empty() && !visit(idx, idx + elem.buffer.size())) {
+                return;
+            }
+        }
+    }
+};
+
+//! \brief The disjoint ranges of stream indices that have arrived ahead of the assembled prefix
+
+//! The ranges are kept in a sorted vector: there are only ever a handful of them, so shifting a few
+//! elements beats chasing tree nodes, and once the vector has grown to its working size inserting
+//! and removing ranges never touches the heap.
+class OutOfOrderIntervals {
+  public:
+    //! the half-open range [begin, end)
+    struct Run {
+        uint64_t begin;
+        uint64_t end;
+    };
+
+  private:
+    std::vector<Run> intervals{};  //!< sorted, and no two ranges overlap or touch
+    size_t bytes{0};
+
+  public:
+    OutOfOrderIntervals() = default;
+    //! \param expected_runs is how many ranges to make room for up front
+    explicit OutOfOrderIntervals(const size_t expected_runs) { intervals.reserve(expected_runs); }
+
+    //! Mark the indices [begin, end) as present, merging with any range they overlap or touch
+    void insert(uint64_t begin, uint64_t end) {
+        // the first range that ends at or after `begin`, i.e. the first one that may be merged
+        auto first = std::partition_point(
+            intervals.begin(), intervals.end(), [begin](const Run &run) { return run.end < begin; });
+        auto last = first;
+        for (; last != intervals.end() && last->begin <= end; ++last) {
+            begin = std::min(begin, last->begin);
+            end = std::max(end, last->end);
+            bytes -= last->end - last->begin;
+        }
+        if (first == last) {
+            intervals.insert(first, Run{begin, end});
+        } else {
+            *first = Run{begin, end};
+            intervals.erase(std::next(first), last);
+        }
+        bytes += end - begin;
+    }
+    //! Remove the range starting at `begin`, if there is one
+    //! \returns the end of the removed range, or `begin` if there is none
+    uint64_t popFrom(const uint64_t begin) {
+        if (intervals.empty() || intervals.front().begin != begin) {
+            return begin;
+        }
+        const auto end = intervals.front().end;
+        bytes -= end - begin;
+        intervals.erase(intervals.begin());
+        return end;
+    }
+    //! \returns the lowest range; only valid if not empty()
+    [[nodiscard]] const Run &front() const { return intervals.front(); }
+    //! \returns the number of indices present, in O(1)
+    [[nodiscard]] size_t size() const { return bytes; }
+    [[nodiscard]] bool empty() const { return intervals.empty(); }
+    //! \returns the number of disjoint ranges
+    [[nodiscard]] size_t runs() const { return intervals.size(); }
+    //! Call `visit(begin, end)` on each range in order, until it returns `false`
+    template <typename F>
+    void forEachRun(F &&visit) const {
+        for (const auto &run : intervals) {
+            if (!visit(run.begin, run.end)) {
+                return;
+            }
+        }
+    }
+};
+
+//! \brief Out-of-order bytes kept in an arena that is allocated once, up front
+
+//! Byte `i` of the stream lives at `arena[i & mask]`. The arena holds at least the reassembler's
+//! capacity, so the bytes of its window never collide, and every segment lands in it with a
+//! memcpy: no per-segment node or string, whatever the reordering.
+class SlabOutOfOrderQueue {
+  private:
+    std::vector<char> arena;
+    size_t mask;
+    OutOfOrderIntervals index;
+
+  public:
+    //! \param capacity is the size of the reassembler's window
+    //! \param expected_runs is how many ranges the index makes room for up front
+    SlabOutOfOrderQueue(const size_t capacity, const size_t expected_runs)
+        : arena(std::max<size_t>(1, capacity)), mask(0), index(expected_runs) {
+        while (mask + 1 < arena.size()) {
+            mask = mask << 1 | 1;
+        }
+        arena.resize(mask + 1);
+    }
+    //! Store `data` as the bytes starting at stream index `idx`
+    void push(const uint64_t idx, std::string_view data) {
+        const auto pos = idx & mask;
+        const auto part = std::min(arena.size() - pos, data.size());
+        memcpy(&arena[pos], data.data(), part);
+        memcpy(arena.data(), data.data() + part, data.size() - part);
+        index.insert(idx, idx + data.size());
+    }
+    //! \returns the stored bytes [begin, end) as up to two views, in stream order
+    [[nodiscard]] std::array<std::string_view, 2> view(const uint64_t begin, const uint64_t end) const {
+        const auto pos = begin & mask;
+        const auto part = std::min<size_t>(arena.size() - pos, end - begin);
+        return {std::string_view{&arena[pos], part}, std::string_view{arena.data(), end - begin - part}};
+    }
+    //! Forget the run starting at `begin`, if any \returns its end, or `begin` if there is none
+    uint64_t popFrom(const uint64_t begin) { return index.popFrom(begin); }
+    //! Mark [begin, end) as stored again (its bytes are still in the arena)
+    void restore(const uint64_t begin, const uint64_t end) { index.insert(begin, end); }
+    //! Make room for a window of `capacity` bytes, moving the stored bytes to a bigger arena if need be
+    void grow(const size_t capacity) {
+        if (capacity <= arena.size()) {
+            return;
+        }
+        auto newMask = mask;
+        while (newMask + 1 < capacity) {
+            newMask = newMask << 1 | 1;
+        }
+        const auto old = std::exchange(arena, std::vector<char>(newMask + 1));
+        const auto oldMask = std::exchange(mask, newMask);
+        index.forEachRun([&](const uint64_t begin, const uint64_t end) {
+            for (auto i = begin; i < end;) {
+                const auto from = i & oldMask;
+                const auto to = i & mask;
+                const auto size = std::min<uint64_t>({end - i, old.size() - from, arena.size() - to});
+                memcpy(&arena[to], &old[from], size);
+                i += size;
+            }
+            return true;
+        });
+    }
+    //! \returns the bytes the arena takes once it has grown to a window of `capacity` bytes
+    [[nodiscard]] size_t footprint(const size_t capacity) const {
+        auto size = arena.size();
+        while (size < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+    [[nodiscard]] const OutOfOrderIntervals &runs() const { return index; }
 };
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
+  public:
+    //! Where the reassembler keeps bytes that arrive ahead of the assembled prefix
+    enum class Backend : uint8_t {
+        Queue,  //!< in an XskTcpOutOfOrderQueue of merged strings, copied into the output when they become contiguous
+        Ring,   //!< at their final offset in the output's free space, tracked by an OutOfOrderIntervals
+        Slab,   //!< in a SlabOutOfOrderQueue, copied into the output when they become contiguous
+    };
+
   private:
     // Your code here -- add private members as necessary.
     XskTcpOutOfOrderQueue queue;
+    OutOfOrderIntervals intervals;
+    std::optional<SlabOutOfOrderQueue> slab{};
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
-    size_t seq{0};
+    const Backend backend;
+    uint64_t seq{0};  //!< the absolute index of the first byte not yet assembled
+    //! the index just past the last byte of the stream, once a segment carrying it has fit in the window
+    //! (for Backend::Queue, only when that segment was empty)
+    std::optional<uint64_t> eofIndex{};
+
+    void pushRing(std::string_view data, uint64_t index, const bool eof);
+    void pushSlab(std::string_view data, uint64_t index, const bool eof);
+    void drain();
+    void drainSlab();
+    //! \returns the index of out-of-order runs, or nullptr for Backend::Queue
+    const OutOfOrderIntervals *outOfOrderRuns() const;
+    //! copy `data` to the end of the output, as far as it fits \returns the number of bytes written
+    size_t writeContiguous(std::string_view data);
+    void copyIntoWindow(std::string_view data, size_t offset);
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    StreamReassembler(const size_t capacity,
+                      const Backend backend_ = Backend::Queue,
+                      const ByteStream::Mode mode = ByteStream::Mode::Ring);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -106,6 +312,24 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring without copying it first
+    //! \details A substring that lands exactly at the end of the assembled bytes, ahead of
+    //! anything stored, is written straight into the stream.
+    void push_substring(std::string_view data, uint64_t index, bool eof);
+
+    //! \brief Receive a substring held in a Buffer (e.g. a TCPSegment's payload)
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
+    //! \brief Let the reassembler and its output hold up to `capacity` bytes (it never shrinks)
+    void grow(const size_t capacity);
+
+    //! \returns the most bytes the reassembler and its output may hold
+    size_t capacity() const { return _capacity; }
+
+    //! \returns the bytes its buffers take once it may hold `capacity` bytes, as allocated (e.g. rounded up
+    //! to a whole ring); the strings Backend::Queue keeps come and go with the bytes, and aren't counted
+    size_t footprint(const size_t capacity) const;
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -118,6 +342,24 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! The number of holes between the reassembled bytes and the substrings stored after them
+    size_t unassembled_holes() const;
+
+    //! \brief The index the stream will be contiguous up to once the first hole is filled
+    //! \returns the end of the first stored substring, or the end of the reassembled bytes if there is none
+    uint64_t contiguous_end() const;
+
+    //! \brief Call `visit(begin, end)` on each range [begin, end) of stored substrings, in stream order,
+    //! until it returns `false`
+    template <typename F>
+    void for_each_stored_run(F &&visit) const {
+        if (const auto *runs = outOfOrderRuns()) {
+            runs->forEachRun(std::forward<F>(visit));
+        } else {
+            queue.forEachRun(std::forward<F>(visit));
+        }
+    }
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
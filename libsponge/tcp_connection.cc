@@ -1,6 +1,8 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 
 // Dummy implementation of a TCP connection
@@ -22,13 +24,38 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 #ifdef DEBUG
     fd.hexdump(seg, true);
 #endif
+    // PAWS（RFC 7323 5.3）：时间戳比 TS.Recent 更旧的数据包可能来自回绕之前的序号空间，
+    // 必须丢弃。若其占用序号空间，则回复一个 ACK 告知对端当前的状态
+    const auto &timestamp = seg.header().options.timestamp;
+    if (_sender.timestamps_enabled() && timestamp.has_value() && _ts_recent.has_value() && !seg.header().rst &&
+        static_cast<int32_t>(timestamp.value().value - _ts_recent.value()) < 0) {
+        if (seg.length_in_sequence_space()) {
+            _sender.send_empty_segment();
+            _trans_segments_to_out_with_ack_and_win();
+        }
+        return;
+    }
+    // 记录对端的时间戳用于回显：只取推进了我方上一个 ACK 的数据包，
+    // 使得延迟 ACK 回显的是最早未确认的数据包的时间戳（RFC 7323 4.3）。
+    // 且必须先确认数据包落在接收窗口内（RFC 7323 5.3 R2、R3），否则一个陈旧或伪造的、
+    // 带着很大时间戳的数据包就能抬高 TS.Recent，使 PAWS 丢弃之后所有正常的数据包
+    if (timestamp.has_value() &&
+        (seg.header().syn || (_last_ack_sent.has_value() && seg.header().seqno - _last_ack_sent.value() <= 0 &&
+                              _in_receive_window(seg))))
+        _ts_recent = timestamp.value().value;
+
     _time_since_last_segment_received_ms = 0;
     // 如果发来的是一个 ACK 包，则无需发送 ACK
     bool need_send_ack = seg.length_in_sequence_space();
 
     // 读取并处理接收到的数据
     // _receiver 足够鲁棒以至于无需进行任何过滤
+    // 记录接收前的状态，用于判断数据段是否按序到达
+    const auto ackno_before = _receiver.ackno();
+    const bool had_gap = _receiver.unassembled_bytes() > 0;
     _receiver.segment_received(seg);
+    const bool in_order = ackno_before.has_value() && !had_gap && seg.header().seqno == ackno_before.value() &&
+                          _receiver.ackno() == ackno_before.value() + seg.length_in_sequence_space();
 
     // 如果是 RST 包，则直接终止
     //! NOTE: 当 TCP 处于任何状态时，均需绝对接受 RST。因为这可以防止尚未到来数据包产生的影响
@@ -37,11 +64,21 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         return;
     }
 
+    // SYN 中携带了对端的选项（例如是否支持 SACK），必须在回复 SYN 之前告知 _sender
+    if (seg.header().syn) {
+        _sender.peer_syn_options(seg.header().options);
+    }
+
     // 如果收到了 ACK 包，则更新 _sender 的状态并补充发送数据
     // NOTE: _sender 足够鲁棒以至于无需关注传入 ack 是否可靠
     assert(_sender.segments_out().empty());
     if (seg.header().ack) {
-        _sender.ack_received(seg.header().ackno, seg.header().win);
+        _sender.sack_received(seg.header().options.sack);
+        _sender.timestamp_received(timestamp);
+        // SYN 中的窗口从不缩放（RFC 7323）
+        const auto shift = seg.header().syn ? 0 : _sender.send_window_shift();
+        const auto window = static_cast<size_t>(seg.header().win) << shift;
+        _sender.ack_received(seg.header().ackno, window, seg.length_in_sequence_space() > 0);
         // _sender.fill_window(); // 这行其实是多余的，因为已经在 ack_received 中被调用了，不过这里显示说明一下其操作
         // 如果原本需要发送空ack，并且此时 sender 发送了新数据，则停止发送空ack
         if (need_send_ack && !_sender.segments_out().empty())
@@ -71,6 +108,8 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     }
 
     // 如果收到的数据包里没有任何数据，则这个数据包可能只是为了 keep-alive
+    if (need_send_ack && _cfg.delayed_ack && _delay_ack(seg, in_order))
+        need_send_ack = false;
     if (need_send_ack)
         _sender.send_empty_segment();
     _trans_segments_to_out_with_ack_and_win();
@@ -85,16 +124,30 @@ size_t TCPConnection::write(const string &data) {
     return write_size;
 }
 
+size_t TCPConnection::write(string &&data) {
+    size_t write_size = _sender.stream_in().write(move(data));
+    _sender.fill_window();
+    _trans_segments_to_out_with_ack_and_win();
+    return write_size;
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
     assert(_sender.segments_out().empty());
     _sender.tick(ms_since_last_tick);
+    _receiver.tick(ms_since_last_tick);
     if (_sender.consecutive_retransmissions() > _cfg.MAX_RETX_ATTEMPTS) {
         // 在发送 rst 之前，需要清空可能重新发送的数据包
         _sender.segments_out().pop();
         _set_rst_state(true);
         return;
     }
+    // 延迟的 ACK 等待超时后单独发送；若有数据包要发送，则由其捎带
+    if (_unacked_bytes > 0) {
+        _ack_delay_ms += ms_since_last_tick;
+        if (_ack_delay_ms >= _cfg.ack_delay && _sender.segments_out().empty())
+            _sender.send_empty_segment();
+    }
     // 转发可能重新发送的数据包
     _trans_segments_to_out_with_ack_and_win();
 
@@ -109,6 +162,29 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
     }
 }
 
+optional<uint64_t> TCPConnection::next_send_time() const {
+    auto next = _sender.next_send_time();
+    if (_unacked_bytes > 0) {
+        const uint64_t ack = _cfg.ack_delay - min<size_t>(_ack_delay_ms, _cfg.ack_delay);
+        next = next.has_value() ? min(next.value(), ack) : ack;
+    }
+    return next;
+}
+
+optional<uint64_t> TCPConnection::next_timer() const {
+    if (!active())
+        return {};
+    auto next = next_send_time();
+    const auto earliest = [&next](const uint64_t ms) { next = next.has_value() ? min(next.value(), ms) : ms; };
+    if (const auto rto = _sender.next_timeout())
+        earliest(rto.value());
+    // TIME_WAIT 在最后一次收到数据包 10 倍 rt_timeout 之后结束
+    if (TCPState::state_summary(_receiver) == TCPReceiverStateSummary::FIN_RECV &&
+        TCPState::state_summary(_sender) == TCPSenderStateSummary::FIN_ACKED && _linger_after_streams_finish)
+        earliest(10 * _cfg.rt_timeout - min<size_t>(_time_since_last_segment_received_ms, 10 * _cfg.rt_timeout));
+    return next;
+}
+
 void TCPConnection::end_input_stream() {
     _sender.stream_in().end_input();
     // 在输入流结束后，必须立即发送 FIN
@@ -116,6 +192,28 @@ void TCPConnection::end_input_stream() {
     _trans_segments_to_out_with_ack_and_win();
 }
 
+void TCPConnection::cork() { _sender.set_cork(true); }
+
+void TCPConnection::uncork() {
+    _sender.set_cork(false);
+    _flush_held_back();
+}
+
+void TCPConnection::set_nodelay(const bool nodelay) {
+    _sender.set_nagle(!nodelay);
+    // 关闭 Nagle 算法后，之前被其扣留的数据可以立即发送
+    if (nodelay)
+        _flush_held_back();
+}
+
+void TCPConnection::_flush_held_back() {
+    // 连接尚未发起时不能调用 fill_window，否则会发出 SYN
+    if (TCPState::state_summary(_sender) == TCPSenderStateSummary::CLOSED)
+        return;
+    _sender.fill_window();
+    _trans_segments_to_out_with_ack_and_win();
+}
+
 void TCPConnection::connect() {
     // 第一次调用 _sender.fill_window 将会发送一个 syn 数据包
     _sender.fill_window();
@@ -149,6 +247,31 @@ void TCPConnection::_set_rst_state(bool send_rst) {
     _is_active = false;
 }
 
+bool TCPConnection::_in_receive_window(const TCPSegment &seg) const {
+    // RFC 793 的可接受性检查：数据段至少有一部分落在 [RCV.NXT, RCV.NXT + RCV.WND) 内，
+    // 不占序号空间的数据段则要求其序号落在其中（窗口为 0 时须恰为 RCV.NXT）
+    const auto ackno = _receiver.ackno();
+    if (!ackno.has_value())
+        return false;
+    const int64_t window = _receiver.window_size();
+    const int64_t begin = seg.header().seqno - ackno.value();
+    const int64_t length = seg.length_in_sequence_space();
+    if (length == 0)
+        return window == 0 ? begin == 0 : begin >= 0 && begin < window;
+    return window > 0 && begin + length > 0 && begin < window;
+}
+
+bool TCPConnection::_delay_ack(const TCPSegment &seg, const bool in_order) {
+    // SYN、FIN、乱序或重复的数据段，以及填补空洞的数据段都需要立即确认，
+    // 以便对端尽快发现丢包（RFC 5681 4.2）
+    if (seg.header().syn || seg.header().fin || !in_order)
+        return false;
+    // 每收到两个满载的数据段至少确认一次；满载以我们通告的 MSS 为准，
+    // 对端发送的数据段可能大于我们自己发送时用的 MSS
+    _unacked_bytes += seg.payload().size();
+    return _unacked_bytes < 2 * _sender.receive_segment_size();
+}
+
 void TCPConnection::_trans_segments_to_out_with_ack_and_win() {
     // 将等待发送的数据包加上本地的 ackno 和 window size
     while (!_sender.segments_out().empty()) {
@@ -157,7 +280,21 @@ void TCPConnection::_trans_segments_to_out_with_ack_and_win() {
         if (_receiver.ackno().has_value()) {
             seg.header().ack = true;
             seg.header().ackno = _receiver.ackno().value();
-            seg.header().win = _receiver.window_size();
+            // 窗口按协商的比例缩小后再写入 16 位的字段，超出部分截断为最大值而非回绕
+            const auto shift = seg.header().syn ? 0 : _sender.receive_window_shift();
+            seg.header().win = min<size_t>(_receiver.window_size() >> shift, UINT16_MAX);
+            auto &timestamp = seg.header().options.timestamp;
+            if (timestamp.has_value() && _ts_recent.has_value())
+                timestamp.value().echo_reply = _ts_recent.value();
+            // 时间戳选项占用 12 字节，剩余空间只够 3 个 SACK 块
+            if (_sender.sack_enabled()) {
+                seg.header().options.sack = _receiver.sack_blocks(
+                    timestamp.has_value() ? TCPOptions::MAX_SACK_BLOCKS_WITH_TIMESTAMP : TCPOptions::MAX_SACK_BLOCKS);
+            }
+            _last_ack_sent = seg.header().ackno;
+            // 任何携带 ACK 的数据包都确认了此前延迟的数据
+            _unacked_bytes = 0;
+            _ack_delay_ms = 0;
         }
 
 #ifdef DEBUG
@@ -161,8 +161,8 @@ struct DebugFile {
 class TCPConnection {
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg};
+    TCPSender _sender{_cfg};
 
 #ifdef DEBUG
     DebugFile fd;
@@ -179,8 +179,24 @@ class TCPConnection {
     size_t _time_since_last_segment_received_ms{0};
     bool _is_active{true};
 
+    //! \name Delayed ACKs
+    //!@{
+    size_t _unacked_bytes{0};  //!< in-order data received since the last ACK we sent
+    size_t _ack_delay_ms{0};   //!< how long the oldest of it has waited for an ACK
+    //! TS.Recent, the peer's TSval to echo ([RFC 7323](\ref rfc::rfc7323))
+    std::optional<uint32_t> _ts_recent{};
+    //! the ackno of the last ACK we sent, which decides whose TSval becomes TS.Recent
+    std::optional<WrappingInt32> _last_ack_sent{};
+    //!@}
+
     void _set_rst_state(bool send_rst);
     void _trans_segments_to_out_with_ack_and_win();
+    //! send what cork() or Nagle's algorithm held back, if the connection has started
+    void _flush_held_back();
+    //! \returns `true` if the ACK for `seg`, which arrived in order if `in_order`, may wait
+    bool _delay_ack(const TCPSegment &seg, const bool in_order);
+    //! does the segment lie (at least partly) within the receive window?
+    bool _in_receive_window(const TCPSegment &seg) const;
 
   public:
     //! \name "Input" interface for the writer
@@ -193,11 +209,27 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write data to the outbound byte stream without copying it, and send it over TCP if possible
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(std::string &&data);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Send only full segments until uncork(), like TCP_CORK, so that several writes share them
+    void cork();
+
+    //! \brief Send what cork() held back, and let short segments go again
+    void uncork();
+
+    //! \brief Turn off Nagle's algorithm (`true`, like TCP_NODELAY) or on (`false`)
+    void set_nodelay(const bool nodelay);
+
+    //! \brief Take no RTT sample from the acknowledgment of what is in flight (see TCPSender::skip_rtt_sample())
+    void skip_rtt_sample() { _sender.skip_rtt_sample(); }
     //!@}
 
     //! \name "Output" interface for the reader
@@ -218,6 +250,8 @@ class TCPConnection {
     size_t time_since_last_segment_received() const;
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
+    //! \brief The sender, for its statistics (e.g. how many bytes it retransmitted)
+    const TCPSender &sender() const { return _sender; }
     //!@}
 
     //! \name Methods for the owner or operating system to call
@@ -229,6 +263,15 @@ class TCPConnection {
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief Milliseconds until a tick() will let out a segment the pacer holds back, or a delayed ACK
+    //! \returns nothing if nothing is waiting on either
+    std::optional<uint64_t> next_send_time() const;
+
+    //! \brief Milliseconds until a tick() would do anything: send, retransmit, or end TIME_WAIT
+    //! \returns nothing if no timer is running, so that the connection needn't be ticked until it
+    //! next receives a segment or a write (see WheelTicker)
+    std::optional<uint64_t> next_timer() const;
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
@@ -0,0 +1,89 @@
+#include "connection_table.hh"
+
+#include "util.hh"
+
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+//! \param[in] capacity the number of connections to make room for
+ConnectionTable::ConnectionTable(const size_t capacity) : _slots(), _key() {
+    size_t slots = 16;
+    while (slots * 3 / 4 < capacity) {
+        slots *= 2;
+    }
+    _slots.resize(slots);
+    auto rng = get_random_generator();
+    _key = (uint64_t{rng()} << 32) | rng();
+}
+
+size_t ConnectionTable::home(const FourTuple &tuple) const {
+    uint64_t h = _key ^ ((uint64_t{tuple.local_address} << 32) | tuple.remote_address);
+    h *= 0xbf58476d1ce4e5b9;
+    h ^= (h >> 31) ^ ((uint64_t{tuple.local_port} << 16) | tuple.remote_port);
+    h *= 0x94d049bb133111eb;
+    h ^= h >> 31;
+    return h & (_slots.size() - 1);
+}
+
+size_t ConnectionTable::probe(const FourTuple &tuple) const {
+    const size_t mask = _slots.size() - 1;
+    size_t i = home(tuple);
+    while (_slots[i].index != EMPTY and _slots[i].tuple != tuple) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void ConnectionTable::grow() {
+    auto old = move(_slots);
+    _slots.assign(old.size() * 2, Slot{});
+    for (const auto &slot : old) {
+        if (slot.index != EMPTY) {
+            _slots[probe(slot.tuple)] = slot;
+        }
+    }
+}
+
+optional<uint32_t> ConnectionTable::find(const FourTuple &tuple) const {
+    const auto &slot = _slots[probe(tuple)];
+    if (slot.index == EMPTY) {
+        return {};
+    }
+    return slot.index;
+}
+
+void ConnectionTable::insert(const FourTuple &tuple, const uint32_t index) {
+    if (index == EMPTY) {
+        throw runtime_error("ConnectionTable: index out of range");
+    }
+    auto *slot = &_slots[probe(tuple)];
+    if (slot->index == EMPTY) {
+        if ((_size + 1) * 4 > _slots.size() * 3) {
+            grow();
+            slot = &_slots[probe(tuple)];
+        }
+        ++_size;
+    }
+    *slot = {tuple, index};
+}
+
+bool ConnectionTable::erase(const FourTuple &tuple) {
+    size_t hole = probe(tuple);
+    if (_slots[hole].index == EMPTY) {
+        return false;
+    }
+    // close the hole by moving back each later entry of the run whose home isn't between the hole and it
+    const size_t mask = _slots.size() - 1;
+    for (size_t next = (hole + 1) & mask; _slots[next].index != EMPTY; next = (next + 1) & mask) {
+        const size_t from_home = (next - home(_slots[next].tuple)) & mask;
+        if (from_home >= ((next - hole) & mask)) {
+            _slots[hole] = _slots[next];
+            hole = next;
+        }
+    }
+    _slots[hole] = Slot{};
+    --_size;
+    return true;
+}
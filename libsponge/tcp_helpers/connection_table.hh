@@ -0,0 +1,59 @@
+#ifndef SPONGE_LIBSPONGE_CONNECTION_TABLE_HH
+#define SPONGE_LIBSPONGE_CONNECTION_TABLE_HH
+
+#include "four_tuple.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//! \brief A hash table from the FourTuple of a connection to a 32-bit index (e.g. into a slab of connections)
+
+//! The table is open-addressed with linear probing: each slot holds a tuple and its index inline,
+//! 16 bytes in all, so a lookup reads one or two adjacent cache lines instead of chasing pointers,
+//! as a chained table like std::unordered_map would. Erasing shifts the rest of a run back instead
+//! of leaving tombstones, so lookups never slow down as connections come and go.
+//!
+//! Tuples are hashed with a per-table random key, so a peer can't pick ports that collide.
+class ConnectionTable {
+  private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;  //!< the index of an unused slot
+
+    struct Slot {
+        FourTuple tuple{};
+        uint32_t index{EMPTY};
+    };
+
+    std::vector<Slot> _slots;
+    size_t _size{0};
+    uint64_t _key;
+
+    size_t home(const FourTuple &tuple) const;
+    //! \returns the slot holding `tuple`, or the empty slot that ends its run
+    size_t probe(const FourTuple &tuple) const;
+    void grow();
+
+  public:
+    //! \brief Construct a table with room for `capacity` connections before it has to grow
+    explicit ConnectionTable(const size_t capacity = 16);
+
+    //! \returns the index stored for `tuple`, if there is one
+    std::optional<uint32_t> find(const FourTuple &tuple) const;
+
+    //! \brief Store `index` for `tuple`, replacing what was stored before
+    //! \note `index` must not be UINT32_MAX
+    void insert(const FourTuple &tuple, const uint32_t index);
+
+    //! \brief Forget `tuple`
+    //! \returns `true` if it was in the table
+    bool erase(const FourTuple &tuple);
+
+    //! \returns the number of tuples in the table
+    size_t size() const { return _size; }
+
+    //! \returns the number of slots, of which at most three quarters are used
+    size_t slots() const { return _slots.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_CONNECTION_TABLE_HH
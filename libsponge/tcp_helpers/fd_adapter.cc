@@ -53,5 +53,28 @@ void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     _sock.sendto(config().destination, seg.serialize(0));
 }
 
+optional<pair<FourTuple, TCPSegment>> TCPOverUDPSocketAdapter::read_any() {
+    auto datagram = _sock.recv();
+
+    TCPSegment seg;
+    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+        return {};
+    }
+
+    const FourTuple tuple{config().source.ipv4_numeric(),
+                          datagram.source_address.ipv4_numeric(),
+                          seg.header().dport,
+                          datagram.source_address.port()};
+    return pair{tuple, move(seg)};
+}
+
+//! \param[in] tuple names the connection `seg` belongs to, our side first
+//! \param[in] seg is the TCP segment to write
+void TCPOverUDPSocketAdapter::write_to(const FourTuple &tuple, TCPSegment &seg) {
+    seg.header().sport = tuple.local_port;
+    seg.header().dport = tuple.remote_port;
+    _sock.sendto(tuple.remote(), seg.serialize(0));
+}
+
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
 template class LossyFdAdapter<TCPOverUDPSocketAdapter>;
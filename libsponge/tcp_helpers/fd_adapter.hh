@@ -2,6 +2,7 @@
 #define SPONGE_LIBSPONGE_FD_ADAPTER_HH
 
 #include "file_descriptor.hh"
+#include "four_tuple.hh"
 #include "lossy_fd_adapter.hh"
 #include "socket.hh"
 #include "tcp_config.hh"
@@ -21,6 +22,10 @@ class FdAdapterBase {
   protected:
     FdAdapterConfig &config_mutable() { return _cfg; }
 
+    //! \returns the largest payload that fits in a `size`-byte datagram along with the TCP header,
+    //! leaving room for as many options as a header can carry
+    static size_t mss_for(const size_t size) { return size - TCPHeader::LENGTH - TCPOptions::MAX_LENGTH; }
+
   public:
     //! \brief Set the listening flag
     //! \param[in] l is the new value for the flag
@@ -48,6 +53,9 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     UDPSocket _sock;
 
   public:
+    //! The largest UDP payload assumed to cross the path unfragmented: an Ethernet MTU less the IPv4 and UDP headers
+    static constexpr size_t UDP_PAYLOAD_MTU = 1500 - 20 - 8;
+
     //! Construct from a UDPSocket sliced into a FileDescriptor
     explicit TCPOverUDPSocketAdapter(UDPSocket &&sock) : _sock(std::move(sock)) {}
 
@@ -57,6 +65,15 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     //! Writes a TCP segment into a UDP payload
     void write(TCPSegment &seg);
 
+    //! Attempts to read a TCP segment of any connection from a UDP payload; the peer's end is the UDP sender
+    std::optional<std::pair<FourTuple, TCPSegment>> read_any();
+
+    //! Writes a TCP segment of the connection named by `tuple` into a UDP payload, sent to the peer's end
+    void write_to(const FourTuple &tuple, TCPSegment &seg);
+
+    //! The largest payload a segment can carry
+    size_t mss() const { return mss_for(UDP_PAYLOAD_MTU); }
+
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
 
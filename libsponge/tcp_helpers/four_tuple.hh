@@ -0,0 +1,37 @@
+#ifndef SPONGE_LIBSPONGE_FOUR_TUPLE_HH
+#define SPONGE_LIBSPONGE_FOUR_TUPLE_HH
+
+#include "address.hh"
+
+#include <cstdint>
+#include <string>
+
+//! \brief The addresses and ports that name a TCP connection, from our side's point of view
+struct FourTuple {
+    uint32_t local_address{0};   //!< our IPv4 address, in host order
+    uint32_t remote_address{0};  //!< the peer's IPv4 address, in host order
+    uint16_t local_port{0};      //!< our port
+    uint16_t remote_port{0};     //!< the peer's port
+
+    //! \brief Name the connection between two endpoints
+    static FourTuple between(const Address &local, const Address &remote) {
+        return {local.ipv4_numeric(), remote.ipv4_numeric(), local.port(), remote.port()};
+    }
+
+    //! \returns our end of the connection
+    Address local() const { return {Address::from_ipv4_numeric(local_address).ip(), local_port}; }
+
+    //! \returns the peer's end of the connection
+    Address remote() const { return {Address::from_ipv4_numeric(remote_address).ip(), remote_port}; }
+
+    bool operator==(const FourTuple &other) const {
+        return local_address == other.local_address and remote_address == other.remote_address and
+               local_port == other.local_port and remote_port == other.remote_port;
+    }
+    bool operator!=(const FourTuple &other) const { return not operator==(other); }
+
+    //! \brief Summarize the tuple in a string, e.g. "10.0.0.1:80 <-> 10.0.0.2:49152"
+    std::string to_string() const { return local().to_string() + " <-> " + remote().to_string(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_FOUR_TUPLE_HH
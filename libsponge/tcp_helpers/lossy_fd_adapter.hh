@@ -2,6 +2,7 @@
 #define SPONGE_LIBSPONGE_LOSSY_FD_ADAPTER_HH
 
 #include "file_descriptor.hh"
+#include "four_tuple.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "util.hh"
@@ -56,6 +57,23 @@ class LossyFdAdapter {
         return _adapter.write(seg);
     }
 
+    //! \brief Like read(), for a segment of any connection (see TCPStack)
+    std::optional<std::pair<FourTuple, TCPSegment>> read_any() {
+        auto ret = _adapter.read_any();
+        if (_should_drop(false)) {
+            return {};
+        }
+        return ret;
+    }
+
+    //! \brief Like write(), for a segment of the connection named by `tuple`
+    void write_to(const FourTuple &tuple, TCPSegment &seg) {
+        if (_should_drop(true)) {
+            return;
+        }
+        return _adapter.write_to(tuple, seg);
+    }
+
     //! \name
     //! Passthrough functions to the underlying AdapterT instance
 
@@ -63,6 +81,7 @@ class LossyFdAdapter {
     void set_listening(const bool l) { _adapter.set_listening(l); }      //!< FdAdapterBase::set_listening passthrough
     const FdAdapterConfig &config() const { return _adapter.config(); }  //!< FdAdapterBase::config passthrough
     FdAdapterConfig &config_mut() { return _adapter.config_mut(); }      //!< FdAdapterBase::config_mut passthrough
+    size_t mss() const { return _adapter.mss(); }                        //!< AdapterT::mss passthrough
     void tick(const size_t ms_since_last_tick) {
         _adapter.tick(ms_since_last_tick);
     }  //!< FdAdapterBase::tick passthrough
@@ -2,10 +2,15 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "memory_budget.hh"
+#include "stream_reassembler.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 
 //! Config for TCP sender and receiver
@@ -15,11 +20,82 @@ class TCPConfig {
     static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr uint16_t RTO_MIN_DFLT = 200;      //!< Default lower bound of an adaptive RTO
+    static constexpr uint32_t RTO_MAX_DFLT = 60000;    //!< Default upper bound of an adaptive RTO, backoff included
+    static constexpr uint16_t ACK_DELAY_DFLT = 40;     //!< Default limit on how long an ACK may be delayed
+    //! Default limit of receive-buffer autotuning
+    static constexpr size_t RECV_CAPACITY_MAX_DFLT = 4 * 1024 * 1024;
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+    //! The largest payload to send, which the SYN also asks the peer to respect (the peer's SYN may lower it).
+    //! If unset, MAX_PAYLOAD_SIZE, except that a TCPSpongeSocket derives it from its adapter's MTU
+    std::optional<size_t> mss{};
+    //! How the receiver holds out-of-order bytes
+    StreamReassembler::Backend reassembler = StreamReassembler::Backend::Queue;
+    //! How the receiver's inbound stream holds the assembled bytes: ByteStream::Mode::Ring, or
+    //! ByteStream::Mode::Mirrored, which costs a memfd and two mappings per connection
+    ByteStream::Mode recv_stream = ByteStream::Mode::Ring;
+    //! The congestion control algorithm of the sender
+    CongestionAlgorithm congestion_control = CongestionAlgorithm::None;
+    //! Derive the retransmission timeout from measured round-trip times ([RFC 6298](\ref rfc::rfc6298)),
+    //! starting from rt_timeout; otherwise it stays at rt_timeout and only doubles
+    bool adaptive_rto = false;
+    uint16_t rto_min = RTO_MIN_DFLT;  //!< Lower bound of the adaptive RTO, in milliseconds
+    uint32_t rto_max = RTO_MAX_DFLT;  //!< Upper bound of the adaptive RTO, in milliseconds
+    //! Resend a segment after three duplicate ACKs instead of waiting for the timer, and recover
+    //! from the loss NewReno-style ([RFC 6582](\ref rfc::rfc6582))
+    bool fast_retransmit = false;
+    //! Offer selective acknowledgments ([RFC 2018](\ref rfc::rfc2018)). If the peer offers them too, the
+    //! receiver reports the blocks it holds and fast recovery resends only what is missing
+    bool sack = false;
+    //! Offer window scaling ([RFC 7323](\ref rfc::rfc7323)), with the smallest shift that lets the window
+    //! cover recv_capacity. Without it, the window advertised never exceeds 65535 bytes
+    bool window_scaling = false;
+    //! Offer timestamps ([RFC 7323](\ref rfc::rfc7323)). If the peer offers them too, every segment carries
+    //! one: the echoes give an RTT sample on every ACK of new data, retransmissions included, and
+    //! protect against wrapped sequence numbers (PAWS)
+    bool timestamps = false;
+    //! Release new segments at cwnd/SRTT instead of in bursts of a whole window, as tick() lets them out.
+    //! Takes effect with congestion control and an adaptive RTO, which measures the SRTT. CongestionAlgorithm::Bbr
+    //! paces at its own rate regardless
+    bool pacing = false;
+    //! Hold back the ACK for in-order data until a second full segment arrives or ack_delay passes
+    //! ([RFC 5681](\ref rfc::rfc5681), section 4.2), so that data sent meanwhile can carry it
+    bool delayed_ack = false;
+    uint16_t ack_delay = ACK_DELAY_DFLT;  //!< Longest a delayed ACK waits, in milliseconds
+    //! Coalesce small writes with Nagle's algorithm: send a segment shorter than the MSS only when nothing
+    //! is in flight. TCPConnection::set_nodelay() turns it off and on later
+    bool nagle = false;
+    //! Grow the receive buffer from recv_capacity as the application reads faster: once per RTT, make room
+    //! for twice what it read in the last one, like Linux's tcp_rcv_space_adjust. An idle connection keeps
+    //! a small buffer, and a fast one isn't held back by it. Window scaling then covers recv_capacity_max
+    bool recv_autotune = false;
+    size_t recv_capacity_max = RECV_CAPACITY_MAX_DFLT;  //!< The largest receive buffer autotuning grows to
+    //! The memory that the receive buffers of all the connections that share it may take together, as allocated
+    //! (whole rings, and the old and new ones both while growing): autotuning stops growing them once it runs out
+    std::shared_ptr<MemoryBudget> recv_budget{};
+};
+
+//! Config for a port that a TCPStack listens on
+class ListenConfig {
+  public:
+    //! \brief When to answer SYNs with SYN cookies ([RFC 4987](\ref rfc::rfc4987))
+
+    //! A SYN cookie is a SYN-ACK whose sequence number encodes the peer's tuple and MSS, keyed by a secret:
+    //! the stack keeps nothing until the ACK of it comes back, so a flood of SYNs costs no memory. The
+    //! connection it opens has no window scaling, SACK or timestamps, which the SYN-ACK can't carry.
+    enum class SynCookies {
+        Never,     //!< drop the SYNs beyond the half-open limit
+        WhenFull,  //!< answer the SYNs beyond the half-open limit with cookies
+        Always,    //!< answer every SYN with a cookie, keeping no half-open connections
+    };
+
+    size_t backlog = 128;      //!< The most established connections to keep waiting for accept()
+    size_t syn_backlog = 256;  //!< The most half-open connections (SYN received, handshake not complete)
+    SynCookies syn_cookies = SynCookies::WhenFull;  //!< What to do with a SYN beyond syn_backlog
 };
 
 //! Config for classes derived from FdAdapter
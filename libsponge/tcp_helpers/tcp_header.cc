@@ -37,8 +37,8 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    options = {};
+    options.parse(p, doff * 4 - TCPHeader::LENGTH);
 
     if (p.error()) {
         return p.get_error();
@@ -47,6 +47,8 @@ ParseResult TCPHeader::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
+size_t TCPHeader::serialized_length() const { return max<size_t>(4 * doff, LENGTH + options.serialize().size()); }
+
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
 string TCPHeader::serialize() const {
     // sanity check
@@ -54,14 +56,16 @@ string TCPHeader::serialize() const {
         throw runtime_error("TCP header too short");
     }
 
+    const string opts = options.serialize();
+    const auto length = max<size_t>(4 * doff, LENGTH + opts.size());
     string ret;
-    ret.reserve(4 * doff);
+    ret.reserve(length);
 
     NetUnparser::u16(ret, sport);              // source port
     NetUnparser::u16(ret, dport);              // destination port
     NetUnparser::u32(ret, seqno.raw_value());  // sequence number
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u8(ret, length / 4 << 4);     // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
@@ -72,7 +76,8 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    ret.append(opts);    // options
+    ret.resize(length);  // expand header to advertised size (zero bytes are End of Option List)
 
     return ret;
 }
@@ -90,13 +95,33 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (options.mss) {
+        ss << "TCP MSS: " << dec << *options.mss << hex << '\n';
+    }
+    if (options.sack_permitted) {
+        ss << "TCP SACK permitted\n";
+    }
+    if (options.window_scale) {
+        ss << "TCP window scale: " << dec << +*options.window_scale << hex << '\n';
+    }
+    if (options.timestamp) {
+        ss << "TCP timestamp: " << dec << options.timestamp->value << ", echo " << options.timestamp->echo_reply << hex
+           << '\n';
+    }
+    for (const auto &block : options.sack) {
+        ss << "TCP SACK: " << block.left << "-" << block.right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    for (const auto &block : options.sack) {
+        ss << ",sack=" << block.left << "-" << block.right;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +129,97 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && options == other.options;
+}
+
+namespace {
+enum OptionKind : uint8_t { END = 0, NOP = 1, MSS = 2, WINDOW_SCALE = 3, SACK_PERMITTED = 4, SACK = 5, TIMESTAMP = 8 };
+}
+
+//! \param[in,out] p is a NetParser positioned at the first option
+//! \param[in] length is the number of option bytes, i.e. 4 * doff - TCPHeader::LENGTH
+//! \details Options sponge doesn't know are skipped. A malformed option ends the parse, but isn't an
+//!          error: like other stacks, we ignore the rest of the options and keep the segment.
+void TCPOptions::parse(NetParser &p, size_t length) {
+    while (length > 0 && !p.error()) {
+        const uint8_t kind = p.u8();
+        --length;
+        if (kind == END) {
+            break;
+        }
+        if (kind == NOP) {
+            continue;
+        }
+        if (length == 0) {
+            break;
+        }
+        const uint8_t size = p.u8();
+        --length;
+        if (size < 2 || size - 2u > length) {
+            break;
+        }
+        const size_t body = size - 2;
+        length -= body;
+        if (kind == MSS && body == 2) {
+            mss = p.u16();
+        } else if (kind == WINDOW_SCALE && body == 1) {
+            window_scale = p.u8();
+        } else if (kind == SACK_PERMITTED && body == 0) {
+            sack_permitted = true;
+        } else if (kind == TIMESTAMP && body == 8) {
+            const uint32_t value = p.u32();
+            timestamp = TimestampOption{value, p.u32()};
+        } else if (kind == SACK && body % 8 == 0) {
+            for (size_t i = 0; i < body; i += 8) {
+                const WrappingInt32 left{p.u32()};
+                sack.push_back({left, WrappingInt32{p.u32()}});
+            }
+        } else {
+            p.remove_prefix(body);
+        }
+    }
+    p.remove_prefix(length);
+}
+
+string TCPOptions::serialize() const {
+    string ret;
+    if (mss) {
+        NetUnparser::u8(ret, MSS);
+        NetUnparser::u8(ret, 4);
+        NetUnparser::u16(ret, *mss);
+    }
+    if (sack_permitted) {
+        NetUnparser::u8(ret, NOP);
+        NetUnparser::u8(ret, NOP);
+        NetUnparser::u8(ret, SACK_PERMITTED);
+        NetUnparser::u8(ret, 2);
+    }
+    if (window_scale) {
+        NetUnparser::u8(ret, NOP);
+        NetUnparser::u8(ret, WINDOW_SCALE);
+        NetUnparser::u8(ret, 3);
+        NetUnparser::u8(ret, *window_scale);
+    }
+    if (timestamp) {
+        NetUnparser::u8(ret, NOP);
+        NetUnparser::u8(ret, NOP);
+        NetUnparser::u8(ret, TIMESTAMP);
+        NetUnparser::u8(ret, 10);
+        NetUnparser::u32(ret, timestamp->value);
+        NetUnparser::u32(ret, timestamp->echo_reply);
+    }
+    // each block takes 8 bytes, after 4 for the option's padding, kind and length
+    const size_t room = MAX_LENGTH - ret.size();
+    const size_t blocks = room < 4 ? 0 : min(sack.size(), (room - 4) / 8);
+    if (blocks > 0) {
+        NetUnparser::u8(ret, NOP);
+        NetUnparser::u8(ret, NOP);
+        NetUnparser::u8(ret, SACK);
+        NetUnparser::u8(ret, 2 + 8 * blocks);
+        for (size_t i = 0; i < blocks; ++i) {
+            NetUnparser::u32(ret, sack[i].left.raw_value());
+            NetUnparser::u32(ret, sack[i].right.raw_value());
+        }
+    }
+    return ret;
 }
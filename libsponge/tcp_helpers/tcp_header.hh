@@ -4,8 +4,59 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <vector>
+
+//! \brief A block of sequence space [left, right) that the receiver holds beyond its ackno
+//! ([RFC 2018](\ref rfc::rfc2018))
+struct SackBlock {
+    WrappingInt32 left;
+    WrappingInt32 right;
+
+    bool operator==(const SackBlock &other) const { return left == other.left && right == other.right; }
+};
+
+//! \brief The timestamps option ([RFC 7323](\ref rfc::rfc7323)): the sender's clock, and the latest
+//! value of the peer's it has seen
+struct TimestampOption {
+    uint32_t value;       //!< TSval, the sender's clock when it sent the segment
+    uint32_t echo_reply;  //!< TSecr, the TSval to echo back; zero unless the segment is an ACK
+
+    bool operator==(const TimestampOption &other) const {
+        return value == other.value && echo_reply == other.echo_reply;
+    }
+};
+
+//! \brief The [TCP](\ref rfc::rfc793) options sponge understands
+//! \note Other options are skipped when parsing, and never sent
+struct TCPOptions {
+    static constexpr size_t MAX_LENGTH = 40;                     //!< the most option bytes a header can carry
+    static constexpr size_t MAX_SACK_BLOCKS = 4;                 //!< the most SACK blocks that fit in the options
+    static constexpr size_t MAX_SACK_BLOCKS_WITH_TIMESTAMP = 3;  //!< the most that fit next to a timestamp
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;              //!< the largest shift a window scale may ask for
+
+    //! the largest segment the sender is willing to receive ([RFC 6691](\ref rfc::rfc6691)), only meaningful on a SYN
+    std::optional<uint16_t> mss{};
+    bool sack_permitted = false;    //!< SACK-permitted ([RFC 2018](\ref rfc::rfc2018)), only meaningful on a SYN
+    std::vector<SackBlock> sack{};  //!< SACK blocks; any that don't fit in the header are left out when serializing
+    //! the sender's window scale, i.e. the shift applied to the windows it advertises
+    //! ([RFC 7323](\ref rfc::rfc7323)), only meaningful on a SYN
+    std::optional<uint8_t> window_scale{};
+    std::optional<TimestampOption> timestamp{};  //!< timestamps ([RFC 7323](\ref rfc::rfc7323))
+
+    //! Parse `length` bytes of options
+    void parse(NetParser &p, size_t length);
+
+    //! Serialize the options, padded to a multiple of 4 bytes
+    std::string serialize() const;
+
+    bool operator==(const TCPOptions &other) const {
+        return mss == other.mss && sack_permitted == other.sack_permitted && window_scale == other.window_scale &&
+               timestamp == other.timestamp && sack == other.sack;
+    }
+};
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
 
@@ -48,14 +99,19 @@ struct TCPHeader {
     uint16_t win = 0;           //!< window size
     uint16_t cksum = 0;         //!< checksum
     uint16_t uptr = 0;          //!< urgent pointer
+    TCPOptions options{};       //!< options
     //!@}
 
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the TCP fields
+    //! \note `doff` is raised as needed to make room for the options
     std::string serialize() const;
 
+    //! \returns the length of the serialized header, options included
+    size_t serialized_length() const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
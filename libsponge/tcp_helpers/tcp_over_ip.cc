@@ -73,15 +73,38 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
 //! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
 //! \param[in] seg is the TCP segment to convert
 InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
+    return wrap_tcp_in_ip(FourTuple::between(config().source, config().destination), seg);
+}
+
+//! \details Unlike unwrap_tcp_in_ip(), this doesn't filter by the adapter's configuration: the caller
+//! looks the tuple up among its connections.
+optional<pair<FourTuple, TCPSegment>> TCPOverIPv4Adapter::unwrap_any_tcp_in_ip(const InternetDatagram &ip_dgram) {
+    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+        return {};
+    }
+
+    TCPSegment tcp_seg;
+    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+        return {};
+    }
+
+    const FourTuple tuple{
+        ip_dgram.header().dst, ip_dgram.header().src, tcp_seg.header().dport, tcp_seg.header().sport};
+    return pair{tuple, move(tcp_seg)};
+}
+
+//! \param[in] tuple names the connection, our side first
+//! \param[in] seg is the TCP segment to convert; its port numbers are set from `tuple`
+InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(const FourTuple &tuple, TCPSegment &seg) {
     // set the port numbers in the TCP segment
-    seg.header().sport = config().source.port();
-    seg.header().dport = config().destination.port();
+    seg.header().sport = tuple.local_port;
+    seg.header().dport = tuple.remote_port;
 
     // create an Internet Datagram and set its addresses and length
     InternetDatagram ip_dgram;
-    ip_dgram.header().src = config().source.ipv4_numeric();
-    ip_dgram.header().dst = config().destination.ipv4_numeric();
-    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    ip_dgram.header().src = tuple.local_address;
+    ip_dgram.header().dst = tuple.remote_address;
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().serialized_length() + seg.payload().size();
 
     // set payload, calculating TCP checksum using information from IP header
     ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
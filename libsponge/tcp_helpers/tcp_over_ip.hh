@@ -3,10 +3,12 @@
 
 #include "buffer.hh"
 #include "fd_adapter.hh"
+#include "four_tuple.hh"
 #include "ipv4_datagram.hh"
 #include "tcp_segment.hh"
 
 #include <optional>
+#include <utility>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
@@ -14,6 +16,13 @@ class TCPOverIPv4Adapter : public FdAdapterBase {
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! \brief Parse the TCP segment in a datagram, whichever connection it belongs to (see TCPStack)
+    //! \returns the segment and the tuple of its connection, or nothing if the payload isn't a valid segment
+    static std::optional<std::pair<FourTuple, TCPSegment>> unwrap_any_tcp_in_ip(const InternetDatagram &ip_dgram);
+
+    //! \brief Wrap a segment of the connection named by `tuple` in an IPv4 datagram
+    static InternetDatagram wrap_tcp_in_ip(const FourTuple &tuple, TCPSegment &seg);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
@@ -5,7 +5,9 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <iostream>
 #include <stdexcept>
@@ -25,10 +27,14 @@ template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        // wake up in time for a segment the pacer holds back
+        const auto next_send = _tcp.value().next_send_time();
+        const auto timeout = static_cast<int>(min<uint64_t>(next_send.value_or(TCP_TICK_MS), TCP_TICK_MS));
+        auto ret = _eventloop.wait_next_event(timeout);
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
+        _apply_socket_options();
 
         if (_tcp.value().active()) {
             const auto next_time = timestamp_ms();
@@ -39,6 +45,22 @@ void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     }
 }
 
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_apply_socket_options() {
+    if (_corked != _tcp_corked) {
+        _tcp_corked = _corked;
+        if (_tcp_corked) {
+            _tcp->cork();
+        } else {
+            _tcp->uncork();
+        }
+    }
+    if (_nodelay != _tcp_nodelay) {
+        _tcp_nodelay = _nodelay;
+        _tcp->set_nodelay(_tcp_nodelay);
+    }
+}
+
 //! \param[in] data_socket_pair is a pair of connected AF_UNIX SOCK_STREAM sockets
 //! \param[in] datagram_interface is the interface for reading and writing datagrams
 template <typename AdaptT>
@@ -52,7 +74,12 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
 
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
-    _tcp.emplace(config);
+    TCPConfig tcp_config = config;
+    if (not tcp_config.mss.has_value()) {
+        tcp_config.mss = _datagram_adapter.mss();
+    }
+    _tcp.emplace(tcp_config);
+    _nodelay = _tcp_nodelay = not tcp_config.nagle;
 
     // Set up the event loop
 
@@ -96,7 +123,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
+            auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
             const auto len = data.size();
             const auto amount_written = _tcp->write(move(data));
             if (amount_written != len) {
@@ -128,10 +155,9 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // Write from the inbound_stream into
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
-            const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
-            inbound.pop_output(bytes_written);
+            const auto views = inbound.peek_view(65536);
+            const auto bytes_written = _thread_data.write(BufferViewList(views.begin(), views.end()), false);
+            inbound.commit_read(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
                 _thread_data.shutdown(SHUT_WR);
@@ -57,6 +57,14 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     bool _fully_acked{false};  //!< Has the outbound data been fully acknowledged by the peer?
 
+    std::atomic_bool _corked{false};  //!< Has the owner corked the socket?
+    std::atomic_bool _nodelay{true};  //!< Has the owner turned off Nagle's algorithm?
+    bool _tcp_corked{false};          //!< _corked, as last passed on to the TCPConnection
+    bool _tcp_nodelay{true};          //!< _nodelay, as last passed on to the TCPConnection
+
+    //! Pass the owner's cork() and set_nodelay() on to the TCPConnection
+    void _apply_socket_options();
+
   public:
     //! Construct from the interface that the TCPConnection thread will use to read and write datagrams
     explicit TCPSpongeSocket(AdaptT &&datagram_interface);
@@ -72,6 +80,18 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
     void listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
+    //! \brief Send only full segments, like setting TCP_CORK, until uncork()
+    //! \note Like the other options below, this takes effect on the TCPConnection thread's next
+    //! tick, after any bytes it has already read from the socket
+    void cork() { _corked = true; }
+
+    //! \brief Send what cork() held back, and let short segments go again
+    void uncork() { _corked = false; }
+
+    //! \brief Turn off Nagle's algorithm (`true`, like TCP_NODELAY) or on (`false`)
+    //! \note connect() and listen_and_accept() set it from TCPConfig::nagle, so call it afterwards
+    void set_nodelay(const bool nodelay) { _nodelay = nodelay; }
+
     //! When a connected socket is destructed, it will send a RST
     ~TCPSpongeSocket();
 
@@ -0,0 +1,321 @@
+#include "tcp_stack.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+//! the MSS a SYN cookie can remember: the peer's is rounded down to one of these
+constexpr array<uint16_t, 7> COOKIE_MSS{64, 536, 1000, 1220, 1380, 1440, 1460};
+//! the index that stands for a SYN without the MSS option
+constexpr uint32_t COOKIE_NO_MSS = COOKIE_MSS.size();
+
+uint64_t mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111eb;
+    return h ^ (h >> 31);
+}
+}  // namespace
+
+TCPStack::TCPStack(const TCPConfig &cfg) : _cfg{cfg} {
+    auto rng = get_random_generator();
+    for (auto &word : _cookie_secret) {
+        word = (uint64_t{rng()} << 32) | rng();
+    }
+}
+
+TCPStack::Socket::Socket(TCPStack &owner, const ConnectionId index, const FourTuple &addresses, const TCPConfig &cfg)
+    : stack(owner), id(index), tuple(addresses), connection(cfg), ticker(owner._wheel, *this) {}
+
+TCPStack::Socket &TCPStack::socket(const ConnectionId id) const {
+    if (id >= _sockets.size() or not _sockets[id]) {
+        throw runtime_error("TCPStack: no connection " + to_string(id));
+    }
+    return *_sockets[id];
+}
+
+TCPStack::ConnectionId TCPStack::open(const FourTuple &tuple, const TCPConfig &cfg) {
+    ConnectionId id;
+    if (_free.empty()) {
+        id = _sockets.size();
+        _sockets.emplace_back();
+    } else {
+        id = _free.back();
+        _free.pop_back();
+    }
+    _sockets[id] = make_unique<Socket>(*this, id, tuple, cfg);
+    _table.insert(tuple, id);
+    return id;
+}
+
+void TCPStack::settle(const ConnectionId id) {
+    auto &sock = *_sockets[id];
+    auto &out = sock.connection.segments_out();
+    while (not out.empty()) {
+        _segments_out.emplace(sock.tuple, move(out.front()));
+        out.pop();
+    }
+
+    if (not sock.connection.active()) {
+        // the tuple may already name a newer connection
+        if (_table.find(sock.tuple) == id) {
+            _table.erase(sock.tuple);
+        }
+        sock.ticker.disarm();
+        // nobody will ask for a connection that died before it was accepted, or after it was closed
+        if (sock.listener) {
+            auto &listener = _listeners.at(*sock.listener);
+            if (sock.queued) {
+                auto &queue = listener.accept_queue;
+                queue.erase(remove(queue.begin(), queue.end(), id), queue.end());
+            } else {
+                --listener.half_open;
+            }
+        }
+        if (sock.listener or sock.closed) {
+            _sockets[id].reset();
+            _free.push_back(id);
+        }
+        return;
+    }
+
+    // the handshake is complete once the SYN we sent is acknowledged
+    const auto &sender = sock.connection.sender();
+    if (sock.listener and not sock.queued and sender.next_seqno_absolute() > sender.bytes_in_flight()) {
+        auto &listener = _listeners.at(*sock.listener);
+        --listener.half_open;
+        listener.accept_queue.push_back(id);
+        sock.queued = true;
+    }
+    sock.ticker.rearm();
+}
+
+void TCPStack::send_reset(const FourTuple &tuple, const TCPSegment &seg) {
+    // as [RFC 793](\ref rfc::rfc793) says to answer a segment for a connection that doesn't exist
+    TCPSegment rst;
+    rst.header().rst = true;
+    if (seg.header().ack) {
+        rst.header().seqno = seg.header().ackno;
+    } else {
+        rst.header().ack = true;
+        rst.header().ackno = seg.header().seqno + seg.length_in_sequence_space();
+    }
+    _segments_out.emplace(tuple, move(rst));
+}
+
+//! \param[in] tuple the connection the SYN is for
+//! \param[in] peer_isn the sequence number of the SYN
+//! \param[in] period the number of SYN_COOKIE_PERIOD_MS that had passed when the SYN arrived
+//! \param[in] mss_index the peer's MSS, as an index into COOKIE_MSS (or COOKIE_NO_MSS)
+//! \returns our initial sequence number: 5 bits of the period, 3 of the MSS index, and 24 of a keyed
+//! hash of all that, which only the holder of the secret can compute
+uint32_t TCPStack::syn_cookie(const FourTuple &tuple,
+                              const WrappingInt32 peer_isn,
+                              const uint64_t period,
+                              const uint32_t mss_index) const {
+    uint64_t h = mix(_cookie_secret[0] ^ ((uint64_t{tuple.local_address} << 32) | tuple.remote_address));
+    h = mix(h ^ (uint64_t{tuple.local_port} << 48) ^ (uint64_t{tuple.remote_port} << 32) ^ peer_isn.raw_value());
+    h = mix(h ^ _cookie_secret[1] ^ (period << 3) ^ mss_index);
+    return ((period % 32) << 27) | (mss_index << 24) | (h & 0xffffff);
+}
+
+void TCPStack::send_syn_cookie(const FourTuple &tuple, const TCPSegment &syn) {
+    uint32_t mss_index = COOKIE_NO_MSS;
+    if (const auto mss = syn.header().options.mss) {
+        mss_index = 0;
+        while (mss_index + 1 < COOKIE_MSS.size() and COOKIE_MSS[mss_index + 1] <= *mss) {
+            ++mss_index;
+        }
+    }
+
+    // the SYN-ACK a connection would send, without the options the cookie can't remember
+    TCPSegment syn_ack;
+    auto &header = syn_ack.header();
+    header.syn = true;
+    header.ack = true;
+    header.seqno = WrappingInt32{syn_cookie(tuple, syn.header().seqno, _wheel.now() / SYN_COOKIE_PERIOD_MS, mss_index)};
+    header.ackno = syn.header().seqno + 1;
+    header.win = min<size_t>(_cfg.recv_capacity, UINT16_MAX);
+    header.options.mss = min<size_t>(_cfg.mss.value_or(TCPConfig::MAX_PAYLOAD_SIZE), UINT16_MAX);
+    _segments_out.emplace(tuple, move(syn_ack));
+}
+
+optional<uint32_t> TCPStack::check_syn_cookie(const FourTuple &tuple, const TCPSegment &ack) const {
+    const uint32_t cookie = (ack.header().ackno - 1).raw_value();
+    const uint32_t mss_index = (cookie >> 24) & 7;
+    const auto peer_isn = ack.header().seqno - 1;
+    const uint64_t now = _wheel.now() / SYN_COOKIE_PERIOD_MS;
+    for (uint64_t age = 0; age < 2 and age <= now; ++age) {
+        if (syn_cookie(tuple, peer_isn, now - age, mss_index) == cookie) {
+            return mss_index;
+        }
+    }
+    return {};
+}
+
+void TCPStack::open_from_syn_cookie(const FourTuple &tuple, const TCPSegment &ack, const uint32_t mss_index) {
+    // replay the handshake: the SYN the cookie remembers, and the SYN-ACK it was, then the ACK
+    TCPConfig cfg = _cfg;
+    cfg.fixed_isn = ack.header().ackno - 1;
+    const auto id = open(tuple, cfg);
+    auto &sock = *_sockets[id];
+    sock.listener = tuple.local_port;
+    ++_listeners.at(tuple.local_port).half_open;
+
+    TCPSegment syn;
+    syn.header().syn = true;
+    syn.header().seqno = ack.header().seqno - 1;
+    syn.header().win = ack.header().win;
+    if (mss_index < COOKIE_NO_MSS) {
+        syn.header().options.mss = COOKIE_MSS[mss_index];
+    }
+    sock.connection.segment_received(syn);
+    sock.connection.segments_out() = {};
+    // the SYN-ACK went out when the cookie was made, not now: timing it would give a zero RTT
+    sock.connection.skip_rtt_sample();
+    sock.connection.segment_received(ack);
+    settle(id);
+}
+
+//! \param[in] port the local port to listen on
+//! \param[in] config the limits on the connections to the port
+void TCPStack::listen(const uint16_t port, const ListenConfig &config) {
+    if (not _listeners.emplace(port, Listener{config}).second) {
+        throw runtime_error("TCPStack: already listening on port " + to_string(port));
+    }
+}
+
+optional<TCPStack::ConnectionId> TCPStack::accept(const uint16_t port) {
+    const auto listener = _listeners.find(port);
+    if (listener == _listeners.end()) {
+        throw runtime_error("TCPStack: not listening on port " + to_string(port));
+    }
+    auto &queue = listener->second.accept_queue;
+    if (queue.empty()) {
+        return {};
+    }
+    const auto id = queue.front();
+    queue.pop_front();
+    _sockets[id]->listener.reset();
+    _sockets[id]->queued = false;
+    return id;
+}
+
+//! \param[in] local our end of the connection; its port may be 0
+//! \param[in] remote the peer's end of the connection
+TCPStack::ConnectionId TCPStack::connect(const Address &local, const Address &remote) {
+    auto tuple = FourTuple::between(local, remote);
+    if (tuple.local_port == 0) {
+        for (size_t tries = 0; tries < 65536 - EPHEMERAL_PORTS_BEGIN; ++tries) {
+            tuple.local_port = _next_ephemeral_port;
+            if (_next_ephemeral_port++ == UINT16_MAX) {
+                _next_ephemeral_port = EPHEMERAL_PORTS_BEGIN;
+            }
+            if (not _table.find(tuple)) {
+                break;
+            }
+        }
+    }
+    if (_table.find(tuple)) {
+        throw runtime_error("TCPStack: " + tuple.to_string() + " is in use");
+    }
+
+    const auto id = open(tuple, _cfg);
+    _sockets[id]->connection.connect();
+    settle(id);
+    return id;
+}
+
+size_t TCPStack::write(const ConnectionId id, const string &data) {
+    auto &sock = socket(id);
+    sock.ticker.catch_up();
+    const auto written = sock.connection.write(data);
+    settle(id);
+    return written;
+}
+
+void TCPStack::end_input_stream(const ConnectionId id) {
+    auto &sock = socket(id);
+    sock.ticker.catch_up();
+    sock.connection.end_input_stream();
+    settle(id);
+}
+
+void TCPStack::close(const ConnectionId id) {
+    auto &sock = socket(id);
+    if (sock.listener) {
+        throw runtime_error("TCPStack: connection " + to_string(id) + " hasn't been accepted");
+    }
+    sock.closed = true;
+    if (sock.connection.active()) {
+        end_input_stream(id);
+    } else {
+        settle(id);
+    }
+}
+
+void TCPStack::segment_received(const FourTuple &tuple, const TCPSegment &seg) {
+    if (const auto id = _table.find(tuple)) {
+        auto &sock = *_sockets[*id];
+        sock.ticker.catch_up();
+        sock.connection.segment_received(seg);
+        settle(*id);
+        return;
+    }
+
+    const auto &header = seg.header();
+    const auto it = _listeners.find(tuple.local_port);
+    if (it != _listeners.end() and not header.rst) {
+        auto &listener = it->second;
+        const auto &config = listener.config;
+        const bool backlog_full = listener.accept_queue.size() >= config.backlog;
+        if (header.syn and not header.ack) {
+            // with no room to accept, drop the SYN, so that the peer retries
+            if (backlog_full) {
+                return;
+            }
+            const bool syn_backlog_full = listener.half_open >= config.syn_backlog;
+            if (config.syn_cookies == ListenConfig::SynCookies::Always or
+                (config.syn_cookies == ListenConfig::SynCookies::WhenFull and syn_backlog_full)) {
+                send_syn_cookie(tuple, seg);
+            } else if (not syn_backlog_full) {
+                const auto id = open(tuple, _cfg);
+                _sockets[id]->listener = tuple.local_port;
+                ++listener.half_open;
+                _sockets[id]->connection.segment_received(seg);
+                settle(id);
+            }
+            return;
+        }
+        if (header.ack and not header.syn and config.syn_cookies != ListenConfig::SynCookies::Never) {
+            if (const auto mss_index = check_syn_cookie(tuple, seg)) {
+                // with no room to accept, the peer's retransmissions will try again
+                if (not backlog_full) {
+                    open_from_syn_cookie(tuple, seg, *mss_index);
+                }
+                return;
+            }
+        }
+    }
+
+    if (not header.rst) {
+        send_reset(tuple, seg);
+    }
+}
+
+//! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
+void TCPStack::tick(const size_t ms_since_last_tick) {
+    _ticked.clear();
+    _wheel.advance(ms_since_last_tick);
+    for (const auto id : _ticked) {
+        // a connection ticked twice may be gone after the first look
+        if (_sockets[id]) {
+            settle(id);
+        }
+    }
+}
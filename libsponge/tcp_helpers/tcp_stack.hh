@@ -0,0 +1,194 @@
+#ifndef SPONGE_LIBSPONGE_TCP_STACK_HH
+#define SPONGE_LIBSPONGE_TCP_STACK_HH
+
+#include "address.hh"
+#include "byte_stream.hh"
+#include "connection_table.hh"
+#include "four_tuple.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "timer_wheel.hh"
+#include "wrapping_integers.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//! \brief Many TCP connections over one adapter, demultiplexed by their FourTuple
+
+//! A TCPSpongeSocket owns one TCPConnection, and an adapter that only lets that connection's segments
+//! through. A TCPStack owns any number of connections and finds the one each segment belongs to in a
+//! ConnectionTable, so one adapter (see read_from() and write_to()) serves them all. A port can listen():
+//! a SYN to it opens a connection, which accept() hands to the owner once the handshake is complete.
+//!
+//! The stack ticks its connections from a TimerWheel, so an idle connection costs nothing per tick().
+class TCPStack {
+  public:
+    using ConnectionId = uint32_t;  //!< Names a connection of the stack, until it is close()d
+
+  private:
+    //! A connection, with what the stack knows about it
+    struct Socket {
+        TCPStack &stack;
+        ConnectionId id;
+        FourTuple tuple;
+        TCPConnection connection;
+        std::optional<uint16_t> listener{};  //!< the listening port that hasn't handed it over yet
+        bool queued{false};                  //!< is it in its listener's accept queue?
+        bool closed{false};                  //!< has the owner given it up?
+        WheelTicker<Socket> ticker;
+
+        Socket(TCPStack &owner, const ConnectionId index, const FourTuple &addresses, const TCPConfig &cfg);
+
+        //! for the WheelTicker: tick the connection, and have the stack look at it after
+        void tick(const size_t ms_since_last_tick) {
+            connection.tick(ms_since_last_tick);
+            stack._ticked.push_back(id);
+        }
+        std::optional<uint64_t> next_timer() const { return connection.next_timer(); }
+    };
+
+    //! A listening port
+    struct Listener {
+        ListenConfig config;
+        size_t half_open{0};                      //!< connections that haven't completed the handshake
+        std::deque<ConnectionId> accept_queue{};  //!< established connections, oldest first
+    };
+
+    TCPConfig _cfg;
+    ConnectionTable _table{};
+    //! declared before the sockets, whose tickers must be destroyed first
+    TimerWheel _wheel{};
+    //! the connections, by ConnectionId; the free slots are listed in `_free`
+    std::vector<std::unique_ptr<Socket>> _sockets{};
+    std::vector<ConnectionId> _free{};
+    std::unordered_map<uint16_t, Listener> _listeners{};
+    //! the connections the wheel ticked during tick()
+    std::vector<ConnectionId> _ticked{};
+    std::queue<std::pair<FourTuple, TCPSegment>> _segments_out{};
+    uint16_t _next_ephemeral_port{EPHEMERAL_PORTS_BEGIN};
+    //! the secret that keys SYN cookies
+    std::array<uint64_t, 2> _cookie_secret{};
+
+    Socket &socket(const ConnectionId id) const;
+    ConnectionId open(const FourTuple &tuple, const TCPConfig &cfg);
+    //! collect what a connection sent after it was handed something, and queue or forget it as its state says
+    void settle(const ConnectionId id);
+    //! answer a segment that belongs to no connection
+    void send_reset(const FourTuple &tuple, const TCPSegment &seg);
+
+    //! \name SYN cookies ([RFC 4987](\ref rfc::rfc4987))
+    //!@{
+    uint32_t syn_cookie(const FourTuple &tuple,
+                        const WrappingInt32 peer_isn,
+                        const uint64_t period,
+                        const uint32_t mss_index) const;
+    //! answer a SYN with a cookie
+    void send_syn_cookie(const FourTuple &tuple, const TCPSegment &syn);
+    //! \returns the MSS index encoded in the cookie an ACK acknowledges, if it is one from the last two periods
+    std::optional<uint32_t> check_syn_cookie(const FourTuple &tuple, const TCPSegment &ack) const;
+    //! open the connection whose handshake an ACK of a cookie completes
+    void open_from_syn_cookie(const FourTuple &tuple, const TCPSegment &ack, const uint32_t mss_index);
+    //!@}
+
+  public:
+    //! connect() picks the local port from this range when asked for port 0
+    static constexpr uint16_t EPHEMERAL_PORTS_BEGIN = 49152;
+
+    //! SYN cookies change their key every period, and a cookie is good for two
+    static constexpr uint64_t SYN_COOKIE_PERIOD_MS = 64000;
+
+    //! Construct a stack whose connections all use `cfg`
+    explicit TCPStack(const TCPConfig &cfg);
+
+    //! \name Methods for the owner of the connections
+    //!@{
+
+    //! \brief Open connections for the SYNs that arrive on `port`, keeping them for accept()
+    //! \note SYNs that arrive when ListenConfig::backlog connections are waiting are dropped, so that
+    //! the peers retry
+    void listen(const uint16_t port, const ListenConfig &config = {});
+
+    //! \returns the oldest connection to `port` whose handshake is complete, if any
+    std::optional<ConnectionId> accept(const uint16_t port);
+
+    //! \brief Open a connection from `local` to `remote`, from an ephemeral port if `local`'s is 0
+    ConnectionId connect(const Address &local, const Address &remote);
+
+    //! \brief Write data to a connection's outbound byte stream
+    //! \returns the number of bytes from `data` that were actually written
+    size_t write(const ConnectionId id, const std::string &data);
+
+    //! \brief Shut down a connection's outbound byte stream
+    void end_input_stream(const ConnectionId id);
+
+    //! \brief The inbound byte stream a connection received from its peer
+    ByteStream &inbound_stream(const ConnectionId id) { return socket(id).connection.inbound_stream(); }
+
+    //! \brief A connection, for its state
+    const TCPConnection &connection(const ConnectionId id) const { return socket(id).connection; }
+
+    //! \brief The tuple of a connection
+    const FourTuple &tuple(const ConnectionId id) const { return socket(id).tuple; }
+
+    //! \brief Give a connection up: it shuts down its outbound stream, and the stack forgets it once it's done
+    //! \note `id` may name another connection after this
+    void close(const ConnectionId id);
+    //!@}
+
+    //! \name Methods for the owner of the adapter
+    //!@{
+
+    //! \brief Hand a segment to the connection named by `tuple` (our side first)
+    //! \details A SYN to a listening port opens a connection, or draws a SYN cookie, and the ACK of
+    //! a cookie opens one; any other segment for a connection the stack doesn't have is answered
+    //! with a RST, unless it is one.
+    void segment_received(const FourTuple &tuple, const TCPSegment &seg);
+
+    //! \brief Called periodically when time elapses
+    void tick(const size_t ms_since_last_tick);
+
+    //! \brief The segments the connections have enqueued for transmission, with their tuples
+    std::queue<std::pair<FourTuple, TCPSegment>> &segments_out() { return _segments_out; }
+
+    //! \brief Read a segment from `adapter` (e.g. a TCPOverIPv4OverTunFdAdapter) and hand it to its connection
+    template <typename AdapterT>
+    void read_from(AdapterT &adapter) {
+        if (auto in = adapter.read_any()) {
+            segment_received(in->first, in->second);
+        }
+    }
+
+    //! \brief Write the segments the connections have enqueued to `adapter`
+    template <typename AdapterT>
+    void write_to(AdapterT &adapter) {
+        while (not _segments_out.empty()) {
+            auto &[tuple, seg] = _segments_out.front();
+            adapter.write_to(tuple, seg);
+            _segments_out.pop();
+        }
+    }
+    //!@}
+
+    //! \returns the number of connections that are still active
+    size_t size() const { return _table.size(); }
+
+    //! \name
+    //! The stack's connections refer to it, so it can be neither copied nor moved
+
+    //!@{
+    TCPStack(const TCPStack &other) = delete;
+    TCPStack &operator=(const TCPStack &other) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_STACK_HH
@@ -17,6 +17,22 @@ TCPOverIPv4OverEthernetAdapter::TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
 }
 
 optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
+    auto ip_dgram = read_datagram();
+    if (ip_dgram) {
+        return unwrap_tcp_in_ip(ip_dgram.value());
+    }
+    return {};
+}
+
+optional<pair<FourTuple, TCPSegment>> TCPOverIPv4OverEthernetAdapter::read_any() {
+    auto ip_dgram = read_datagram();
+    if (ip_dgram) {
+        return unwrap_any_tcp_in_ip(ip_dgram.value());
+    }
+    return {};
+}
+
+optional<InternetDatagram> TCPOverIPv4OverEthernetAdapter::read_datagram() {
     // Read Ethernet frame from the raw device
     EthernetFrame frame;
     if (frame.parse(_tap.read()) != ParseResult::NoError) {
@@ -29,11 +45,7 @@ optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
     // The incoming frame may have caused the NetworkInterface to send a frame.
     send_pending();
 
-    // Try to interpret IPv4 datagram as TCP
-    if (ip_dgram) {
-        return unwrap_tcp_in_ip(ip_dgram.value());
-    }
-    return {};
+    return ip_dgram;
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
@@ -48,6 +60,13 @@ void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
     send_pending();
 }
 
+//! \param[in] tuple names the connection `seg` belongs to, our side first
+//! \param[in] seg the TCPSegment to send
+void TCPOverIPv4OverEthernetAdapter::write_to(const FourTuple &tuple, TCPSegment &seg) {
+    _interface.send_datagram(wrap_tcp_in_ip(tuple, seg), _next_hop);
+    send_pending();
+}
+
 void TCPOverIPv4OverEthernetAdapter::send_pending() {
     while (not _interface.frames_out().empty()) {
         _tap.write(_interface.frames_out().front().serialize());
@@ -30,6 +30,21 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
     //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
     void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
 
+    //! Attempts to read and parse an IPv4 datagram containing a TCP segment for any connection
+    std::optional<std::pair<FourTuple, TCPSegment>> read_any() {
+        InternetDatagram ip_dgram;
+        if (ip_dgram.parse(_tun.read()) != ParseResult::NoError) {
+            return {};
+        }
+        return unwrap_any_tcp_in_ip(ip_dgram);
+    }
+
+    //! Creates an IPv4 datagram from a TCP segment of the connection named by `tuple` and writes it to the TUN device
+    void write_to(const FourTuple &tuple, TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(tuple, seg).serialize()); }
+
+    //! The largest payload a segment can carry, given the TUN device's MTU
+    size_t mss() const { return mss_for(_tun.mtu() - IPv4Header::LENGTH); }
+
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
 
@@ -51,6 +66,9 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
 
     void send_pending();  //!< Sends any pending Ethernet frames
 
+    //! Reads an Ethernet frame and returns the IPv4 datagram it carries, if any
+    std::optional<InternetDatagram> read_datagram();
+
   public:
     //! Construct from a TapFD
     explicit TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
@@ -63,9 +81,18 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
     void write(TCPSegment &seg);
 
+    //! Like read(), but for a segment of any connection
+    std::optional<std::pair<FourTuple, TCPSegment>> read_any();
+
+    //! Sends a TCP segment of the connection named by `tuple`
+    void write_to(const FourTuple &tuple, TCPSegment &seg);
+
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! The largest payload a segment can carry, given the TAP device's MTU
+    size_t mss() const { return mss_for(_tap.mtu() - IPv4Header::LENGTH); }
+
     //! Access the underlying raw Ethernet connection
     operator TapFD &() { return _tap; }
 
@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -7,12 +9,25 @@
 
 using namespace std;
 
+//! \param[in] config supplies the capacity, the reassembler's backend, the stream's mode and the autotuning limits
+TCPReceiver::TCPReceiver(const TCPConfig &config)
+    : TCPReceiver(config.recv_capacity, config.reassembler, config.recv_stream) {
+    if (config.recv_autotune) {
+        capacityMax = max(config.recv_capacity, config.recv_capacity_max);
+    }
+    charge = MemoryCharge(config.recv_budget, reassembler.footprint(capacity));
+}
+
 void TCPReceiver::segment_received(const TCPSegment &seg) {
     if (flags & FIN) {
         return;
     }
     auto newOffset = offset;
     auto seqno = seg.header().seqno;
+    if (!(flags & SYN) && !seg.header().syn) {
+        // before the SYN there is no ISN to place the segment against (nor to unwrap later ones near)
+        return;
+    }
     if (seg.header().syn) {
         isn = WrappingInt32{seqno};
         if (flags & SYN) {
@@ -21,14 +36,70 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         flags = SYN;
         newOffset = 1;
     }
-    const auto str = seg.payload().copy();
-    checkPoint = unwrap(seqno, isn, checkPoint);
-    reassembler.push_substring(str, checkPoint - offset, seg.header().fin);
+    // unwrap near the next byte expected, so that a stray segment can't move where later ones land
+    const auto index = unwrap(seqno, isn, reassembler.stream_out().bytes_written() + 1) - offset;
+    reassembler.push_substring(seg.payload(), index, seg.header().fin);
+    if (seg.payload().size() > 0 && index > reassembler.stream_out().bytes_written()) {
+        lastOutOfOrder = index;
+    }
     if (reassembler.stream_out().input_ended()) {
         flags |= FIN;
         newOffset = 2;
     }
     offset = newOffset;
+    if (capacity < capacityMax) {
+        autotune();
+    }
+}
+
+//! \details As Linux's tcp_rcv_space_adjust does: once per RTT, compare what the application read
+//! in it with the most it read in one before, and if it read more, make room for twice as much, and
+//! more again in proportion to the growth, so that the buffer keeps ahead of a sender in slow start.
+void TCPReceiver::autotune() {
+    const auto &stream = stream_out();
+    const uint64_t written = stream.bytes_written();
+    // a sample is the time from offering a window to receiving the end of it: an RTT if the peer sends
+    // as fast as the window lets it, and more if it doesn't, so the least is kept
+    if (rttStart && written >= rttEnd) {
+        const uint64_t sample = max<uint64_t>(clock - *rttStart, 1);
+        rtt = rtt ? min(*rtt, sample) : sample;
+        rttStart.reset();
+    }
+    if (!rttStart && window_size() > 0) {
+        rttStart = clock;
+        rttEnd = written + window_size();
+    }
+
+    if (!rtt || clock - drainStart < *rtt) {
+        return;
+    }
+    const size_t drained = stream.bytes_read() - drainedBefore;
+    drainStart = clock;
+    drainedBefore = stream.bytes_read();
+    if (drained <= drainSpace) {
+        return;
+    }
+    size_t wanted = 2 * drained;
+    if (drainSpace > 0) {
+        wanted += 2 * wanted * (drained - drainSpace) / drainSpace;
+    }
+    drainSpace = drained;
+    wanted = min(wanted, capacityMax);
+    if (wanted <= capacity) {
+        return;
+    }
+    // growing copies the bytes to bigger buffers before it frees the old ones, so the new ones are taken
+    // in full first, and as big as they fit
+    const auto before = reassembler.footprint(capacity);
+    const auto taken = charge.grow(reassembler.footprint(wanted));
+    while (reassembler.footprint(wanted) > max(taken, before)) {
+        wanted -= (wanted - capacity + 1) / 2;
+    }
+    const auto after = reassembler.footprint(wanted);
+    // give back the old buffers, or the new ones if the old ones are big enough still
+    charge.shrink(taken - after + before);
+    capacity = wanted;
+    reassembler.grow(capacity);
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -41,3 +112,34 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
 size_t TCPReceiver::window_size() const {
     return reassembler.stream_out().bytes_read() + capacity - reassembler.stream_out().bytes_written();
 }
+
+vector<SackBlock> TCPReceiver::sack_blocks(const size_t max) const {
+    vector<SackBlock> blocks;
+    if (!(flags & SYN) || max == 0 || reassembler.empty()) {
+        return blocks;
+    }
+    // stream index i has sequence number i + 1: the SYN comes first
+    const auto block = [this](const uint64_t begin, const uint64_t end) {
+        return SackBlock{wrap(begin + 1, isn), wrap(end + 1, isn)};
+    };
+    optional<uint64_t> latest{};
+    if (lastOutOfOrder) {
+        reassembler.for_each_stored_run([&](const uint64_t begin, const uint64_t end) {
+            if (begin <= *lastOutOfOrder && *lastOutOfOrder < end) {
+                blocks.push_back(block(begin, end));
+                latest = begin;
+            }
+            return begin <= *lastOutOfOrder;
+        });
+    }
+    reassembler.for_each_stored_run([&](const uint64_t begin, const uint64_t end) {
+        if (blocks.size() == max) {
+            return false;
+        }
+        if (begin != latest) {
+            blocks.push_back(block(begin, end));
+        }
+        return true;
+    });
+    return blocks;
+}
@@ -2,12 +2,15 @@
 #define SPONGE_LIBSPONGE_TCP_RECEIVER_HH
 
 #include "byte_stream.hh"
+#include "memory_budget.hh"
 #include "stream_reassembler.hh"
+#include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
 #include <cstdint>
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -20,21 +23,46 @@ class TCPReceiver {
 
     //! The maximum number of bytes we'll store.
     size_t capacity;
-    size_t checkPoint{};
     WrappingInt32 isn{UINT32_MAX};
     uint8_t flags{0};
     uint8_t offset{0};
+    //! the stream index of the latest segment stored out of order, which the first SACK block must cover
+    std::optional<uint64_t> lastOutOfOrder{};
     enum Flag : uint8_t {
         SYN = 1 << 0,
         FIN = 1 << 1,
     };
 
+    //! \name Receive-buffer autotuning (see TCPConfig::recv_autotune)
+    //!@{
+    size_t capacityMax;      //!< the most `capacity` may grow to: itself, unless autotuning
+    MemoryCharge charge{};   //!< the buffer's share of TCPConfig::recv_budget
+    uint64_t clock{0};       //!< the milliseconds ticked so far
+    //! how long the peer takes to fill the window it is offered: as close to the RTT as the receiver can tell
+    std::optional<uint64_t> rtt{};
+    std::optional<uint64_t> rttStart{};  //!< when the window of the current sample was offered
+    uint64_t rttEnd{0};                  //!< the stream index whose arrival ends the current sample
+    uint64_t drainStart{0};              //!< when the current measurement of the application's reads began
+    uint64_t drainedBefore{0};           //!< the bytes it had read by then
+    size_t drainSpace{0};                //!< the most bytes it has read in one RTT
+    //! measure the RTT and the application's reads, and grow the buffer once it reads faster
+    void autotune();
+    //!@}
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity_) : reassembler(capacity_), capacity(capacity_) {}
+    //! \param backend how the reassembler holds out-of-order bytes
+    //! \param mode how the inbound stream holds the assembled bytes
+    TCPReceiver(const size_t capacity_,
+                const StreamReassembler::Backend backend = StreamReassembler::Backend::Queue,
+                const ByteStream::Mode mode = ByteStream::Mode::Ring)
+        : reassembler(capacity_, backend, mode), capacity(capacity_), capacityMax(capacity_) {}
+
+    //! \brief Construct a TCP receiver from the capacity, buffers and autotuning of `config`
+    explicit TCPReceiver(const TCPConfig &config);
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -57,6 +85,12 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     [[nodiscard]] size_t window_size() const;
+
+    //! \brief The SACK blocks to send to the peer ([RFC 2018](\ref rfc::rfc2018))
+    //! \param max is the most blocks to return
+    //! \returns the ranges held beyond the ackno: the one holding the latest out-of-order segment
+    //! first, as the RFC requires, then the others from the lowest up
+    [[nodiscard]] std::vector<SackBlock> sack_blocks(const size_t max) const;
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
@@ -65,6 +99,15 @@ class TCPReceiver {
     //! \brief handle an inbound segment
     void segment_received(const TCPSegment &seg);
 
+    //! \brief Called when time elapses, for the autotuning of the buffer
+    void tick(const size_t ms_since_last_tick) { clock += ms_since_last_tick; }
+
+    //! \returns the most bytes the receiver will store, which autotuning may have grown
+    [[nodiscard]] size_t buffer_capacity() const { return capacity; }
+
+    //! \returns the RTT that autotuning measured, if it has
+    [[nodiscard]] std::optional<uint64_t> rtt_estimate() const { return rtt; }
+
     //! \name "Output" interface for the reader
     //!@{
     [[nodiscard]] ByteStream &stream_out() { return reassembler.stream_out(); }
@@ -4,8 +4,10 @@
 #include "tcp_segment.hh"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <random>
+#include <utility>
 
 // Dummy implementation of a TCP sender
 
@@ -18,19 +20,211 @@ using namespace std;
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
 TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
-    : _isn(fixed_isn.value_or(WrappingInt32{random_device()()})), retxTimer(retx_timeout), _stream(capacity) {}
+    : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
+    , retxTimer(retx_timeout)
+    , _stream(capacity, ByteStream::Mode::Chunked) {}
+
+//! \param[in] config supplies the capacity, timeout, ISN, congestion control algorithm and RTO bounds
+TCPSender::TCPSender(const TCPConfig &config) : TCPSender(config.send_capacity, config.rt_timeout, config.fixed_isn) {
+    mss = config.mss.value_or(TCPConfig::MAX_PAYLOAD_SIZE);
+    mssOffer = std::min<size_t>(mss, UINT16_MAX);
+    congestion = make_congestion_control(config.congestion_control, mss);
+    fastRetransmit = config.fast_retransmit;
+    sackOffer = config.sack;
+    timestampOffer = config.timestamps;
+    pacing = config.pacing;
+    nagle = config.nagle;
+    if (config.window_scaling) {
+        // the window may grow to the autotuning limit, but the shift is only agreed on in the SYNs
+        const auto window = config.recv_autotune ? std::max(config.recv_capacity, config.recv_capacity_max)
+                                                 : config.recv_capacity;
+        uint8_t shift = 0;
+        while (shift < TCPOptions::MAX_WINDOW_SCALE && window >> shift > UINT16_MAX) {
+            ++shift;
+        }
+        windowScaleOffer = shift;
+    }
+    if (config.adaptive_rto) {
+        rtt.emplace(config.rto_min, std::max<uint64_t>(config.rto_max, config.rto_min));
+    }
+}
+
+void TCPSender::rttEstimator::sample(const uint64_t ms_rtt) noexcept {
+    const auto r = static_cast<double>(ms_rtt);
+    if (!sampled) {
+        _srtt = r;
+        _rttvar = r / 2;
+        sampled = true;
+        return;
+    }
+    _rttvar = 0.75 * _rttvar + 0.25 * std::abs(_srtt - r);
+    _srtt = 0.875 * _srtt + 0.125 * r;
+}
+
+uint64_t TCPSender::rttEstimator::rto() const noexcept {
+    // the clock granularity is one tick, i.e. a millisecond
+    const auto rto = static_cast<uint64_t>(std::ceil(_srtt + std::max(1.0, 4 * _rttvar)));
+    return std::clamp(rto, minRto, maxRto);
+}
+
+std::optional<double> TCPSender::srtt() const {
+    if (!rtt || !rtt->has_sample()) {
+        return {};
+    }
+    return rtt->srtt();
+}
+
+std::optional<double> TCPSender::rttvar() const {
+    if (!rtt || !rtt->has_sample()) {
+        return {};
+    }
+    return rtt->rttvar();
+}
+
+void TCPSender::transmit(const bool syn, Buffer payload, const bool fin) {
+    if (backup.empty()) {
+        // the time spent idle isn't time spent delivering
+        deliveredAt = firstSentAt = now;
+    }
+    const auto seqno = _next_seqno;
+    _next_seqno += syn + payload.size() + fin;
+    backup.push_back({seqno, std::move(payload), syn, fin, now, false, {delivered, deliveredAt, firstSentAt}});
+    _segments_out.push(materialize(backup.back()));
+}
+
+TCPSegment TCPSender::materialize(const Outstanding &packet) const {
+    TCPSegment seg;
+    auto &header = seg.header();
+    header.seqno = wrap(packet.seqno, _isn);
+    header.syn = packet.syn;
+    header.fin = packet.fin;
+    if (packet.syn) {
+        header.options.mss = mssOffer;
+        header.options.sack_permitted = sackOffer;
+        header.options.window_scale = windowScaleOffer;
+    }
+    if (packet.syn ? timestampOffer : timestampOn) {
+        header.options.timestamp = TimestampOption{timestamp_clock(), 0};
+    }
+    seg.payload() = packet.payload;
+    return seg;
+}
+
+void TCPSender::retransmit(Outstanding &packet) {
+    packet.retransmitted = true;
+    _retransmitted_bytes += packet.payload.size();
+    _segments_out.push(materialize(packet));
+}
+
+void TCPSender::skip_rtt_sample() {
+    for (auto &packet : backup) {
+        packet.retransmitted = true;
+    }
+}
+
+void TCPSender::peer_syn_options(const TCPOptions &options) {
+    if (options.mss && *options.mss > 0 && *options.mss < mss) {
+        mss = *options.mss;
+        if (congestion) {
+            congestion->set_mss(mss);
+        }
+    }
+    sackOn = sackOffer && options.sack_permitted;
+    // answer a SYN that doesn't offer SACK without offering it either
+    sackOffer = sackOn;
+    timestampOn = timestampOffer && options.timestamp.has_value();
+    timestampOffer = timestampOn;
+    if (windowScaleOffer && options.window_scale) {
+        sendShift = std::min(*options.window_scale, TCPOptions::MAX_WINDOW_SCALE);
+        receiveShift = *windowScaleOffer;
+    } else {
+        windowScaleOffer.reset();
+    }
+}
+
+void TCPSender::timestamp_received(const optional<TimestampOption> &timestamp) {
+    if (timestampOn && timestamp) {
+        echoed = timestamp->echo_reply;
+    }
+}
+
+void TCPSender::sack_received(const vector<SackBlock> &blocks) {
+    if (!sackOn || backup.empty()) {
+        return;
+    }
+    for (const auto &block : blocks) {
+        const auto left = unwrap(block.left, _isn, ackno);
+        const auto right = unwrap(block.right, _isn, ackno);
+        // blocks at or below the ackno (D-SACK) or beyond what was sent carry nothing for the scoreboard
+        if (left <= ackno || right <= left || right > _next_seqno) {
+            continue;
+        }
+        for (auto &packet : backup) {
+            const auto begin = packet.seqno;
+            const auto end = begin + packet.length();
+            if (begin >= right) {
+                break;
+            }
+            if (left <= begin && end <= right && !packet.sacked) {
+                packet.sacked = true;
+                markDelivered(packet);
+            }
+        }
+    }
+    // a segment with three segments' worth SACKed above it is deemed lost
+    size_t sackedAbove = 0;
+    for (auto it = backup.rbegin(); it != backup.rend(); ++it) {
+        if (it->sacked) {
+            sackedAbove += it->length();
+        } else if (sackedAbove >= 3 * mss) {
+            it->lost = true;
+        }
+    }
+}
+
+size_t TCPSender::pipe() const {
+    size_t bytes = 0;
+    for (const auto &packet : backup) {
+        if (!packet.sacked && (!packet.lost || packet.resent)) {
+            bytes += packet.length();
+        }
+    }
+    return bytes;
+}
+
+void TCPSender::retransmitLost() {
+    for (auto &packet : backup) {
+        if (packet.sacked || !packet.lost || packet.resent) {
+            continue;
+        }
+        if (congestionRoom() < packet.length()) {
+            return;
+        }
+        packet.resent = true;
+        retransmit(packet);
+        // after an RTO, the holes are resent in slow start, not by fast retransmit
+        if (inRecovery) {
+            ++_fast_retransmissions;
+        }
+    }
+}
 
 uint64_t TCPSender::bytes_in_flight() const { return _next_seqno - ackno; }
 
+size_t TCPSender::congestionRoom() const {
+    if (!congestion) {
+        return SIZE_MAX;
+    }
+    // in SACK recovery, the scoreboard knows what has left the network; otherwise duplicate ACKs inflate the window
+    const auto inFlight = sackRecovery() ? pipe() : bytes_in_flight();
+    const auto cwnd = congestion->cwnd() + inflation;
+    return cwnd > inFlight ? cwnd - inFlight : 0;
+}
+
 void TCPSender::fill_window() {
     if (!(flags & SYN)) {
-        TCPSegment frame;
-        auto &header = frame.header();
-        header.syn = true;
-        header.seqno = wrap(_next_seqno++, _isn);
-        _segments_out.push(frame);
         windows--;
-        backup.push_back(std::move(frame));
+        transmit(true, {}, false);
         flags |= SYN;
         return;
     }
@@ -40,34 +234,43 @@ void TCPSender::fill_window() {
     if (_stream.buffer_empty()) {
         if (!(flags & FIN) && _stream.eof() && windows > 0) {
             retxTimer.reset();
-            TCPSegment frame;
-            auto &header = frame.header();
-            header.fin = true;
-            header.seqno = wrap(_next_seqno++, _isn);
             --windows;
-            _segments_out.push(frame);
-            backup.push_back(std::move(frame));
+            transmit(false, {}, true);
             flags |= FIN;
         }
         return;
     }
+    pacedBytes = 0;
     while (windows > 0) {
-        TCPSegment seg;
-        seg.header().seqno = wrap(_next_seqno, _isn);
-        auto size = std::min(windows, _stream.buffer_size());
-        size = std::min(size, TCPConfig::MAX_PAYLOAD_SIZE);
+        const auto room = congestionRoom();
+        if (room < std::min(mss, _stream.buffer_size())) {
+            // wait until the congestion window has room for a full segment
+            return;
+        }
+        const auto size = std::min({windows, room, _stream.buffer_size(), mss});
+        if (size < mss && size == _stream.buffer_size() && !_stream.input_ended() &&
+            (corked || (nagle && bytes_in_flight() > 0))) {
+            // the writer may yet fill the segment out
+            return;
+        }
+        const auto rate = pacingRate();
+        if (rate && pacingTokens < size) {
+            // tick() lets the segment out once the pacer has earned enough
+            pacedBytes = size;
+            return;
+        }
+        if (rate) {
+            pacingTokens -= size;
+        }
         windows -= size;
-        _next_seqno += size;
-        auto payload = _stream.read(size);
-        if (_stream.eof() && windows > 0) {
-            seg.header().fin = true;
+        const auto payload = _stream.read_buffer(size);
+        const bool fin = _stream.eof() && windows > 0;
+        if (fin) {
             flags |= FIN;
             --windows;
-            ++_next_seqno;
         }
-        seg.payload() = Buffer(std::move(payload));
-        _segments_out.push(seg);
-        backup.push_back(std::move(seg));
+        // the payload only needs a copy when it straddles two of the writer's chunks
+        transmit(false, payload.buffers().size() == 1 ? Buffer(payload) : Buffer(payload.concatenate()), fin);
         if (_stream.buffer_empty()) {
             if (_stream.eof() && !(flags & FIN)) {
                 continue;
@@ -77,13 +280,87 @@ void TCPSender::fill_window() {
     }
 }
 
+void TCPSender::markDelivered(const Outstanding &packet) {
+    const auto bytes = packet.payload.size();
+    delivered += bytes;
+    deliveredAt = now;
+    newlyDelivered += bytes;
+    if (!priorDelivery || packet.prior.delivered >= priorDelivery->delivered) {
+        priorDelivery = packet.prior;
+        newestSentAt = firstSentAt = packet.sentAt;
+    }
+}
+
+void TCPSender::rateSample(const optional<uint64_t> rtt_sample) {
+    if (congestion && newlyDelivered > 0) {
+        // the slower of the rates at which the segments were sent and acknowledged, so that
+        // neither a burst of sends nor a compressed train of ACKs passes for bandwidth
+        const auto interval = std::max(now - priorDelivery->deliveredAt, newestSentAt - priorDelivery->firstSentAt);
+        const RateSample sample{delivered,
+                                priorDelivery->delivered,
+                                interval,
+                                newlyDelivered,
+                                sackOn ? pipe() : bytes_in_flight(),
+                                rtt_sample};
+        congestion->on_rate_sample(sample, now);
+    }
+    newlyDelivered = 0;
+    priorDelivery.reset();
+}
+
+void TCPSender::duplicateAck() {
+    ++_duplicate_acks;
+    ++dupAcks;
+    if (!fastRetransmit) {
+        return;
+    }
+    if (inRecovery) {
+        if (sackOn) {
+            retransmitLost();
+        } else {
+            // another segment has left the network, so another may enter it
+            inflation += mss;
+        }
+        fill_window();
+        return;
+    }
+    // duplicates of an ack the last recovery was waiting for don't start another one
+    if (dupAcks != 3 || (recoverPoint && ackno <= *recoverPoint)) {
+        return;
+    }
+    inRecovery = true;
+    recoverPoint = _next_seqno;
+    if (congestion) {
+        congestion->on_loss(bytes_in_flight(), now);
+    }
+    if (sackOn) {
+        // a hole resent in the last recovery may still be on its way: only an RTO forgets what was resent
+        auto &front = backup.front();
+        if (!front.resent) {
+            front.lost = front.resent = true;
+            retransmitOldest();
+            ++_fast_retransmissions;
+        }
+        retransmitLost();
+    } else {
+        inflation = 3 * mss;
+        retransmitOldest();
+        ++_fast_retransmissions;
+    }
+    fill_window();
+}
+
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno_, const uint16_t window_size) {
+//! \param carries_data Whether the segment that brought the ackno carried data too
+void TCPSender::ack_received(const WrappingInt32 ackno_, const size_t window_size, const bool carries_data) {
     auto absoluteAck = unwrap(ackno_, _isn, ackno);
+    const auto echo = std::exchange(echoed, std::nullopt);
     if (absoluteAck < ackno || absoluteAck > _next_seqno) {
         return;
     }
+    const bool windowUpdate = window_size != lastWindow;
+    lastWindow = window_size;
     if (window_size) {
         auto maxSeq = absoluteAck + window_size;
         if (maxSeq > _next_seqno + windows) {
@@ -96,33 +373,150 @@ void TCPSender::ack_received(const WrappingInt32 ackno_, const uint16_t window_s
     }
 
     if (absoluteAck == ackno) {
+        // what the SACK blocks delivered
+        rateSample({});
+        if (!carries_data && !windowUpdate && !backup.empty() && !(flags & WINDOWS_DETECT)) {
+            duplicateAck();
+        }
+        if (sackRecovery() && !inRecovery) {
+            // after an RTO, what the SACK blocks delivered makes room for the holes, then new data
+            retransmitLost();
+            fill_window();
+        }
         return;
     }
+    dupAcks = 0;
+    // the SYN doesn't count as data acknowledged
+    const auto acked = absoluteAck - std::max<uint64_t>(ackno, 1);
+    // the window doesn't grow while recovering from a loss
+    if (congestion && acked > 0 && !inRecovery) {
+        congestion->on_ack(acked, bytes_in_flight(), now);
+    }
     ackno = absoluteAck;
     restrans = 0;
-    retxTimer.reset();
+    // an ack covering a retransmission is ambiguous, even for the later segments it covers:
+    // it was sent in response to the retransmission, however long ago they went out
+    std::optional<uint64_t> rttSample{};
+    bool ambiguous = false;
     while (!backup.empty()) {
-        const auto packet = backup.front();
-        auto packetBound = unwrap(packet.header().seqno, _isn, ackno) + packet.length_in_sequence_space();
-        if (packetBound > absoluteAck) {
-            return;
+        const auto &packet = backup.front();
+        if (packet.seqno + packet.length() > absoluteAck) {
+            break;
+        }
+        ambiguous |= packet.retransmitted;
+        rttSample = now - packet.sentAt;
+        if (!packet.sacked) {
+            markDelivered(packet);
         }
         backup.pop_front();
     }
+    if (echo) {
+        // the echo is of the segment that last moved the receiver's ackno, so it isn't ambiguous
+        // even when that segment was a retransmission ([RFC 7323](\ref rfc::rfc7323), section 4)
+        rttSample = static_cast<uint32_t>(timestamp_clock() - *echo);
+        ambiguous = false;
+    }
+    if (rtt && rttSample && !ambiguous) {
+        rtt->sample(*rttSample);
+        retxTimer.setInitial(rtt->rto());
+    }
+    rateSample(ambiguous ? std::nullopt : rttSample);
+    retxTimer.reset();
+    if (inRecovery) {
+        if (absoluteAck >= *recoverPoint) {
+            inRecovery = false;
+            inflation = 0;
+        } else if (sackOn) {
+            // a partial ack: the next hole is lost too, along with any the scoreboard knows of
+            if (!backup.front().resent) {
+                backup.front().resent = true;
+                retransmitOldest();
+                ++_fast_retransmissions;
+            }
+            retransmitLost();
+        } else if (!backup.empty()) {
+            // a partial ack: the next hole is lost too. Deflate by what left the network,
+            // but let one new segment follow the retransmission
+            inflation = (inflation > acked ? inflation - acked : 0) + (acked >= mss ? mss : 0);
+            retransmitOldest();
+            ++_fast_retransmissions;
+        }
+    } else if (sackRecovery()) {
+        // after an RTO, slow start resends the holes ahead of new data
+        retransmitLost();
+    }
     fill_window();
 }
 
+optional<double> TCPSender::pacingRate() const {
+    if (congestion) {
+        if (const auto rate = congestion->pacing_rate()) {
+            return rate;
+        }
+    }
+    if (!pacing || !congestion || !rtt || !rtt->has_sample()) {
+        return {};
+    }
+    // like Linux, leave room to grow: slow start doubles cwnd every round trip
+    const double gain = congestion->in_slow_start() ? 2.0 : 1.2;
+    return gain * static_cast<double>(congestion->cwnd()) / std::max(rtt->srtt(), 1.0);
+}
+
+optional<uint64_t> TCPSender::next_send_time() const {
+    const auto rate = pacingRate();
+    if (pacedBytes == 0 || !rate) {
+        return {};
+    }
+    return static_cast<uint64_t>(std::ceil((static_cast<double>(pacedBytes) - pacingTokens) / *rate));
+}
+
+optional<uint64_t> TCPSender::next_timeout() const {
+    if (backup.empty()) {
+        return {};
+    }
+    return retxTimer.remaining();
+}
+
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
+    now += ms_since_last_tick;
     retxTimer.ticket(ms_since_last_tick);
+    if (const auto rate = pacingRate()) {
+        // the bucket holds two segments, or a millisecond's worth at high rates, so that an idle
+        // sender can't save up a burst
+        const auto depth = std::max(2.0 * static_cast<double>(mss), *rate);
+        pacingTokens = std::min(pacingTokens + *rate * static_cast<double>(ms_since_last_tick), depth);
+        if (pacedBytes > 0 && pacingTokens >= static_cast<double>(pacedBytes)) {
+            fill_window();
+        }
+    }
     if (!retxTimer.timeout()) {
         return;
     }
     if (!backup.empty()) {
+        // a zero-window probe going unanswered says nothing about congestion; nor does a
+        // segment timing out again after the window has already collapsed
+        if (congestion && !(flags & WINDOWS_DETECT) && restrans == 0) {
+            congestion->on_rto(bytes_in_flight(), now);
+        }
+        inRecovery = false;
+        inflation = 0;
+        dupAcks = 0;
+        // what the receiver SACKed stays SACKed (RFC 6675, section 5.1), and the rest is presumed lost:
+        // slow start resends it, and no fast recovery begins, until what was sent so far is acknowledged
+        for (auto &packet : backup) {
+            packet.lost = sackOn && !packet.sacked;
+            packet.resent = false;
+        }
+        if (sackOn) {
+            recoverPoint = _next_seqno;
+            backup.front().resent = true;
+        }
         restrans += 1;
-        _segments_out.push(backup.front());
+        ++_timeouts;
+        retransmitOldest();
         if (!(flags & WINDOWS_DETECT)) {
-            retxTimer.doubleTimeout();
+            retxTimer.doubleTimeout(rtt ? rtt->max_rto() : UINT64_MAX);
         }
         retxTimer.restart();
     }
@@ -133,5 +527,8 @@ unsigned int TCPSender::consecutive_retransmissions() const { return restrans; }
 void TCPSender::send_empty_segment() {
     TCPSegment seg{};
     seg.header().seqno = wrap(_next_seqno, _isn);
+    if (timestampOn) {
+        seg.header().options.timestamp = TimestampOption{timestamp_clock(), 0};
+    }
     _segments_out.push(seg);
 }
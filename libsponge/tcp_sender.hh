@@ -2,16 +2,20 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <queue>
+#include <vector>
 
 //! \brief The "sender" part of a TCP implementation.
 
@@ -23,19 +27,76 @@ class TCPSender {
     class logicTimer {
         uint64_t ms_pass{0};
         uint64_t ms_current_timeout;
-        const uint64_t ms_init_timeout;
+        uint64_t ms_init_timeout;
 
       public:
         explicit logicTimer(uint64_t ms_timeout) noexcept
             : ms_current_timeout(ms_timeout), ms_init_timeout(ms_timeout) {}
         void ticket(uint64_t ms) noexcept { ms_pass += ms; }
-        void doubleTimeout() noexcept { ms_current_timeout <<= 1; }
+        void doubleTimeout(uint64_t ms_limit = UINT64_MAX) noexcept {
+            ms_current_timeout = std::min(ms_current_timeout << 1, std::max(ms_limit, ms_current_timeout));
+        }
+        //! the timeout to return to on the next reset()
+        void setInitial(uint64_t ms_timeout) noexcept { ms_init_timeout = ms_timeout; }
+        [[nodiscard]] uint64_t current() const noexcept { return ms_current_timeout; }
         void restart() noexcept { ms_pass = 0; }
         void reset() noexcept {
             ms_current_timeout = ms_init_timeout;
             restart();
         }
         [[nodiscard]] bool timeout() const noexcept { return ms_pass >= ms_current_timeout; }
+        [[nodiscard]] uint64_t remaining() const noexcept {
+            return ms_current_timeout - std::min(ms_pass, ms_current_timeout);
+        }
+    };
+
+    //! \brief Smoothed round-trip time and the retransmission timeout derived from it ([RFC 6298](\ref rfc::rfc6298))
+    class rttEstimator {
+        double _srtt{0};
+        double _rttvar{0};
+        bool sampled{false};
+        const uint64_t minRto;
+        const uint64_t maxRto;
+
+      public:
+        rttEstimator(uint64_t ms_min, uint64_t ms_max) noexcept : minRto(ms_min), maxRto(ms_max) {}
+        //! fold in a round-trip time measured on a segment that was never retransmitted
+        void sample(uint64_t ms_rtt) noexcept;
+        [[nodiscard]] bool has_sample() const noexcept { return sampled; }
+        [[nodiscard]] double srtt() const noexcept { return _srtt; }
+        [[nodiscard]] double rttvar() const noexcept { return _rttvar; }
+        [[nodiscard]] uint64_t rto() const noexcept;
+        [[nodiscard]] uint64_t max_rto() const noexcept { return maxRto; }
+    };
+
+    //! the sender's delivery counters when a segment was sent, which its acknowledgment compares against
+    struct Delivery {
+        uint64_t delivered;    //!< bytes delivered
+        uint64_t deliveredAt;  //!< when that count last grew
+        uint64_t firstSentAt;  //!< when the most recently sent segment delivered by then was sent
+    };
+
+    //! \brief a segment sent but not yet fully acknowledged
+
+    //! Only what tells it apart is kept: the payload shares the storage the stream handed out, and the
+    //! TCPSegment itself is built each time it is (re)sent.
+    struct Outstanding {
+        uint64_t seqno;      //!< the absolute sequence number of its first byte (or the SYN)
+        Buffer payload;
+        bool syn;
+        bool fin;
+        uint64_t sentAt;     //!< when it was first sent, on the sender's clock
+        bool retransmitted;  //!< Karn's algorithm: an ack covering a retransmission gives no RTT sample
+        Delivery prior;      //!< for the delivery rate its acknowledgment samples
+        //! \name The SACK scoreboard ([RFC 6675](\ref rfc::rfc6675))
+        //!@{
+        bool sacked{false};  //!< the receiver holds the whole segment
+        bool lost{false};    //!< enough was SACKed above the segment to deem it lost
+        bool resent{false};  //!< retransmitted during the current recovery
+        //!@}
+
+        //! \returns the sequence space it occupies
+        size_t length() const { return syn + payload.size() + fin; }
     };
 
   private:
@@ -49,7 +110,7 @@ class TCPSender {
     logicTimer retxTimer;
     //! outgoing stream of bytes that have not yet been sent
     ByteStream _stream;
-    std::deque<TCPSegment> backup;
+    std::deque<Outstanding> backup{};
     size_t ms_send{0};
     size_t windows{1};
     size_t ackno{0};
@@ -58,6 +119,115 @@ class TCPSender {
     enum Flag : uint8_t { SYN = 1 << 0, FIN = 1 << 2, WINDOWS_DETECT = 1 << 3 };
     uint8_t flags{0};
     uint32_t restrans{0};
+    //! the largest payload to send: ours, or the peer's MSS if that is smaller
+    size_t mss{TCPConfig::MAX_PAYLOAD_SIZE};
+    //! the MSS our SYN offers
+    uint16_t mssOffer{TCPConfig::MAX_PAYLOAD_SIZE};
+    //! the congestion controller, if the sender runs one
+    std::unique_ptr<CongestionControl> congestion{};
+    //! the sender's clock: the sum of its ticks, in milliseconds
+    uint64_t now{0};
+    //! the round-trip time estimator, if the retransmission timeout adapts to it
+    std::optional<rttEstimator> rtt{};
+
+    //! \name Fast retransmit and fast recovery ([RFC 5681](\ref rfc::rfc5681), [RFC 6582](\ref rfc::rfc6582))
+    //!@{
+    bool fastRetransmit{false};
+    unsigned dupAcks{0};  //!< consecutive duplicate ACKs
+    size_t lastWindow{0};
+    bool inRecovery{false};
+    //! the end of what had been sent when recovery began; only an ack beyond it completes recovery
+    std::optional<uint64_t> recoverPoint{};
+    //! the allowance on top of cwnd for segments that duplicate ACKs show have left the network
+    size_t inflation{0};
+    uint64_t _duplicate_acks{0};
+    uint64_t _fast_retransmissions{0};
+    //!@}
+
+    //! \name Selective acknowledgments ([RFC 2018](\ref rfc::rfc2018))
+    //!@{
+    bool sackOffer{false};  //!< whether our SYN offers SACK
+    bool sackOn{false};     //!< whether both ends offered SACK
+    //!@}
+
+    //! \name Window scaling ([RFC 7323](\ref rfc::rfc7323))
+    //!@{
+    std::optional<uint8_t> windowScaleOffer{};  //!< the shift our SYN offers for the windows our receiver advertises
+    uint8_t sendShift{0};                       //!< the peer's shift, in effect once both ends offered one
+    uint8_t receiveShift{0};                    //!< our shift, in effect once both ends offered one
+    //!@}
+
+    //! \name Timestamps ([RFC 7323](\ref rfc::rfc7323))
+    //!@{
+    bool timestampOffer{false};        //!< whether our SYN offers timestamps
+    bool timestampOn{false};           //!< whether both ends offered them
+    std::optional<uint32_t> echoed{};  //!< the TSecr of the ACK about to be processed
+    //!@}
+    uint64_t _retransmitted_bytes{0};
+    uint64_t _timeouts{0};
+
+    //! \name Pacing
+    //!@{
+    bool pacing{false};
+    double pacingTokens{0};  //!< the bytes the pacer lets out before more must be earned
+    size_t pacedBytes{0};    //!< the size of the segment the pacer holds back, or zero
+    //!@}
+
+    //! \name Coalescing small writes
+    //!@{
+    bool nagle{false};   //!< hold back a short segment while data is in flight (Nagle's algorithm)
+    bool corked{false};  //!< hold back short segments until uncorked
+    //!@}
+
+    //! \name Delivery rate estimation, for model-based congestion control
+    //!@{
+    uint64_t delivered{0};     //!< bytes of data acknowledged or SACKed so far
+    uint64_t deliveredAt{0};   //!< when delivered last grew, or the sender last went from idle to busy
+    uint64_t firstSentAt{0};   //!< when the most recently sent segment delivered so far was sent
+    size_t newlyDelivered{0};  //!< bytes delivered since the last rate sample
+    uint64_t newestSentAt{0};  //!< when the most recently sent segment among them was sent
+    //! the counters that segment was sent with
+    std::optional<Delivery> priorDelivery{};
+    //!@}
+
+    //! queue a new segment for transmission and keep it until acknowledged
+    void transmit(const bool syn, Buffer payload, const bool fin);
+
+    //! \returns the segment to send for an outstanding one
+    TCPSegment materialize(const Outstanding &packet) const;
+
+    //! send an outstanding segment again
+    void retransmit(Outstanding &packet);
+
+    //! send the oldest outstanding segment again
+    void retransmitOldest() { retransmit(backup.front()); }
+
+    //! during SACK recovery, resend the segments the scoreboard deems lost, as far as cwnd allows
+    void retransmitLost();
+
+    //! \returns whether the scoreboard drives what is sent: during SACK recovery, and after an RTO
+    //! until what was sent before it is acknowledged ([RFC 6675](\ref rfc::rfc6675), section 5.1)
+    bool sackRecovery() const { return sackOn && recoverPoint && ackno < *recoverPoint; }
+
+    //! \returns the SACK estimate of the bytes still in the network ([RFC 6675](\ref rfc::rfc6675))
+    size_t pipe() const;
+
+    //! count a segment as delivered, the first time it is SACKed or acknowledged
+    void markDelivered(const Outstanding &packet);
+
+    //! report what was delivered since the last sample to the congestion controller
+    void rateSample(const std::optional<uint64_t> rtt_sample);
+
+    //! handle an ACK that acknowledges nothing new while data is outstanding
+    void duplicateAck();
+
+    //! \returns how much more sequence space the congestion window allows in flight
+    size_t congestionRoom() const;
+
+    //! \returns the rate, in bytes per millisecond, at which the pacer lets segments out: the congestion
+    //! controller's, if it sets one, or else cwnd/SRTT, with some headroom. Empty if the sender doesn't pace,
+    //! or can't yet (no RTT sample)
+    std::optional<double> pacingRate() const;
 
   public:
     //! Initialize a TCPSender
@@ -65,6 +235,9 @@ class TCPSender {
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
               const std::optional<WrappingInt32> fixed_isn = {});
 
+    //! Initialize a TCPSender from the sender's side of a TCPConfig (including congestion control and loss recovery)
+    explicit TCPSender(const TCPConfig &config);
+
     //! \name "Input" interface for the writer
     //!@{
     ByteStream &stream_in() { return _stream; }
@@ -75,7 +248,25 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param[in] carries_data whether the acknowledging segment carried data, which rules it out as a duplicate ACK
+    //! \param[in] window_size the window in bytes, i.e. already scaled by send_window_shift()
+    void ack_received(const WrappingInt32 ackno, const size_t window_size, const bool carries_data = false);
+
+    //! \brief The peer's SYN arrived, with these options
+    //! \note The peer's MSS option may lower the MSS. SACK and window scaling are only used if both SYNs
+    //! offer them, so a SYN answering one that doesn't offer them doesn't either
+    void peer_syn_options(const TCPOptions &options);
+
+    //! \brief SACK blocks arrived (before the ackno and window of the same segment)
+    void sack_received(const std::vector<SackBlock> &blocks);
+
+    //! \brief An ACK's timestamp option arrived (before its ackno and window, like its SACK blocks)
+    //! \note If the ACK acknowledges new data, its echo times the round trip, retransmission or not
+    void timestamp_received(const std::optional<TimestampOption> &timestamp);
+
+    //! \brief Take no RTT sample from the acknowledgment of what is outstanding, as if it were retransmitted
+    //! \note For a segment that was never sent when it says, like the SYN-ACK a SYN cookie stands for
+    void skip_rtt_sample();
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -83,6 +274,14 @@ class TCPSender {
     //! \brief create and send segments to fill as much of the window as possible
     void fill_window();
 
+    //! \brief Turn Nagle's algorithm on or off: while on, a segment shorter than the MSS waits for
+    //! everything in flight to be acknowledged, gathering the writes that arrive meanwhile
+    void set_nagle(const bool on) { nagle = on; }
+
+    //! \brief Cork or uncork the sender: while corked, it only sends full segments (and the FIN)
+    //! \note Uncorking doesn't send what was held back; call fill_window() for that
+    void set_cork(const bool on) { corked = on; }
+
     //! \brief Notifies the TCPSender of the passage of time
     void tick(const size_t ms_since_last_tick);
     //!@}
@@ -95,9 +294,66 @@ class TCPSender {
     //! (see TCPSegment::length_in_sequence_space())
     size_t bytes_in_flight() const;
 
+    //! \brief The largest payload the sender puts in a segment
+    size_t max_segment_size() const { return mss; }
+
+    //! \brief The largest payload the peer may send us: the MSS our SYN offers
+    size_t receive_segment_size() const { return mssOffer; }
+
+    //! \brief When the pacer will let out the segment it holds back
+    //! \returns the milliseconds until then, or nothing if the pacer isn't holding anything back
+    std::optional<uint64_t> next_send_time() const;
+
+    //! \brief When the retransmission timer will expire
+    //! \returns the milliseconds until then, or nothing if no segment is outstanding
+    std::optional<uint64_t> next_timeout() const;
+
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Whether both ends offered SACK, so that the receiver should send SACK blocks
+    //! and the sender heeds them
+    bool sack_enabled() const { return sackOn; }
+
+    //! \brief Whether both ends offered timestamps, so that every segment carries one
+    bool timestamps_enabled() const { return timestampOn; }
+
+    //! \returns the clock our segments' TSvals come from: the milliseconds ticked so far
+    uint32_t timestamp_clock() const { return static_cast<uint32_t>(now); }
+
+    //! \brief The shift to apply to the windows the peer advertises, except on its SYN
+    uint8_t send_window_shift() const { return sendShift; }
+
+    //! \brief The shift to apply to the windows our receiver advertises, except on our SYN
+    uint8_t receive_window_shift() const { return receiveShift; }
+
+    //! \brief Number of payload bytes sent more than once, by the timer or by fast retransmit
+    uint64_t retransmitted_bytes() const { return _retransmitted_bytes; }
+
+    //! \brief Number of times the retransmission timer expired with data outstanding
+    uint64_t timeouts() const { return _timeouts; }
+
+    //! \brief Number of duplicate ACKs received so far
+    uint64_t duplicate_acks() const { return _duplicate_acks; }
+
+    //! \brief Number of segments resent by fast retransmit or during fast recovery, rather than on a timeout
+    uint64_t fast_retransmissions() const { return _fast_retransmissions; }
+
+    //! \brief The current retransmission timeout, including any exponential backoff, in milliseconds
+    uint64_t rto() const { return retxTimer.current(); }
+
+    //! \brief The smoothed round-trip time, in milliseconds
+    //! \returns an empty optional until the sender adapts its RTO and has measured a round trip
+    std::optional<double> srtt() const;
+
+    //! \brief The round-trip time variation, in milliseconds
+    //! \returns an empty optional until the sender adapts its RTO and has measured a round trip
+    std::optional<double> rttvar() const;
+
+    //! \brief The congestion controller
+    //! \returns nullptr if the sender runs without congestion control
+    const CongestionControl *congestion_control() const { return congestion.get(); }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
@@ -7,11 +7,23 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    if (_storage and _starting_offset == _ending_offset) {
         _storage.reset();
     }
 }
 
+Buffer Buffer::prefix(const size_t n) const {
+    if (n > size()) {
+        throw out_of_range("Buffer::prefix");
+    }
+    if (n == 0) {
+        return {};
+    }
+    Buffer ret{*this};
+    ret._ending_offset = _starting_offset + n;
+    return ret;
+}
+
 void BufferList::append(const BufferList &other) {
     for (const auto &buf : other._buffers) {
         _buffers.push_back(buf);
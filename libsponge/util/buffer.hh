@@ -16,12 +16,14 @@ class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _ending_offset{};
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept
+        : _storage(std::make_shared<std::string>(std::move(str))), _ending_offset(_storage->size()) {}
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -29,7 +31,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _ending_offset - _starting_offset};
     }
 
     operator std::string_view() const { return str(); }
@@ -47,6 +49,10 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief A Buffer that shares this one's storage but only covers its first `n` bytes
+    //! \note Like remove_prefix(), this does not copy; the storage lives as long as any slice of it.
+    Buffer prefix(const size_t n) const;
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -113,6 +119,16 @@ class BufferViewList {
 
     //! \brief Construct from a std::string_view
     BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
+
+    //! \brief Construct from a range of std::string_views (empty views are skipped)
+    template <typename Iterator>
+    BufferViewList(Iterator begin, Iterator end) {
+        for (; begin != end; ++begin) {
+            if (not begin->empty()) {
+                _views.push_back(*begin);
+            }
+        }
+    }
     //!@}
 
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
@@ -73,6 +73,28 @@ string FileDescriptor::read(const size_t limit) {
     return ret;
 }
 
+//! \param[in] iovecs are the regions to be filled, in order
+//! \param[in] count is the number of regions
+//! \returns the number of bytes read; fewer bytes than the regions can hold may be returned
+size_t FileDescriptor::read(const iovec *iovecs, const size_t count) {
+    size_t limit = 0;
+    for (size_t i = 0; i < count; i++) {
+        limit += iovecs[i].iov_len;
+    }
+
+    const ssize_t bytes_read = SystemCall("readv", ::readv(fd_num(), iovecs, count));
+    if (limit > 0 && bytes_read == 0) {
+        _internal_fd->_eof = true;
+    }
+    if (bytes_read > static_cast<ssize_t>(limit)) {
+        throw runtime_error("readv() read more than requested");
+    }
+
+    register_read();
+
+    return bytes_read;
+}
+
 size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
     size_t total_bytes_written = 0;
 
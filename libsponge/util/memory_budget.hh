@@ -0,0 +1,110 @@
+#ifndef SPONGE_LIBSPONGE_MEMORY_BUDGET_HH
+#define SPONGE_LIBSPONGE_MEMORY_BUDGET_HH
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+//! \brief A limit on the memory that many objects (e.g. the receive buffers of TCP connections) take together
+
+//! Thread-safe, so that the connections of several TCPSpongeSockets, each in its own thread, may share one.
+class MemoryBudget {
+  private:
+    const size_t _limit;
+    std::atomic<size_t> _used{0};
+
+  public:
+    //! Construct a budget of `limit` bytes
+    explicit MemoryBudget(const size_t limit) : _limit(limit) {}
+
+    //! \brief Take `bytes` whether or not they fit (e.g. for the buffer an object can't do without)
+    void charge(const size_t bytes) { _used += bytes; }
+
+    //! \brief Take as many of `bytes` as the budget has left
+    //! \returns the number of bytes taken
+    size_t reserve(const size_t bytes) {
+        auto used = _used.load();
+        while (true) {
+            const auto taken = std::min(bytes, _limit - std::min(used, _limit));
+            if (taken == 0 || _used.compare_exchange_weak(used, used + taken)) {
+                return taken;
+            }
+        }
+    }
+
+    //! \brief Give back `bytes` that were taken
+    void release(const size_t bytes) { _used -= bytes; }
+
+    //! \returns the number of bytes taken
+    size_t used() const { return _used; }
+
+    //! \returns the number of bytes that may be taken
+    size_t limit() const { return _limit; }
+};
+
+//! \brief Bytes taken from a MemoryBudget, which are given back when the charge is destroyed
+class MemoryCharge {
+  private:
+    std::shared_ptr<MemoryBudget> _budget{};
+    size_t _bytes{0};
+
+  public:
+    //! Construct a charge of nothing, against no budget
+    MemoryCharge() = default;
+
+    //! Take `bytes` from `budget`, whether or not they fit; with no budget, just count them
+    MemoryCharge(std::shared_ptr<MemoryBudget> budget, const size_t bytes) : _budget(std::move(budget)), _bytes(bytes) {
+        if (_budget) {
+            _budget->charge(bytes);
+        }
+    }
+
+    ~MemoryCharge() {
+        if (_budget) {
+            _budget->release(_bytes);
+        }
+    }
+
+    //! \brief Take up to `bytes` more
+    //! \returns the number of bytes taken: all of them with no budget
+    size_t grow(const size_t bytes) {
+        const auto taken = _budget ? _budget->reserve(bytes) : bytes;
+        _bytes += taken;
+        return taken;
+    }
+
+    //! \brief Give back `bytes` of those taken
+    void shrink(const size_t bytes) {
+        _bytes -= bytes;
+        if (_budget) {
+            _budget->release(bytes);
+        }
+    }
+
+    //! \returns the number of bytes taken
+    size_t bytes() const { return _bytes; }
+
+    //! \name
+    //! A MemoryCharge can be moved, but cannot be copied
+
+    //!@{
+    MemoryCharge(const MemoryCharge &other) = delete;
+    MemoryCharge &operator=(const MemoryCharge &other) = delete;
+    MemoryCharge(MemoryCharge &&other) noexcept
+        : _budget(std::move(other._budget)), _bytes(std::exchange(other._bytes, 0)) {}
+    MemoryCharge &operator=(MemoryCharge &&other) noexcept {
+        if (this != &other) {
+            if (_budget) {
+                _budget->release(_bytes);
+            }
+            _budget = std::move(other._budget);
+            _bytes = std::exchange(other._bytes, 0);
+        }
+        return *this;
+    }
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_MEMORY_BUDGET_HH
@@ -0,0 +1,59 @@
+#include "mirrored_memory.hh"
+
+#include "file_descriptor.hh"
+#include "util.hh"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+//! \details A power of two that is a multiple of the page size, which is what both mappings need.
+size_t MirroredMemory::size_for(const size_t min_size) {
+    size_t size = sysconf(_SC_PAGESIZE);
+    while (size < min_size) {
+        size <<= 1;
+    }
+    return size;
+}
+
+//! \param[in] min_size is the minimum number of bytes the ring must hold
+MirroredMemory::MirroredMemory(const size_t min_size) : _size(size_for(min_size)) {
+    // the memfd is only needed until both views are mapped; FileDescriptor closes it
+    FileDescriptor memfd{SystemCall("memfd_create", ::memfd_create("sponge-ring", MFD_CLOEXEC))};
+    SystemCall("ftruncate", ::ftruncate(memfd.fd_num(), _size));
+
+    // reserve twice the address space, then map the same pages over both halves
+    void *base = ::mmap(nullptr, 2 * _size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+    _base = static_cast<uint8_t *>(base);
+    for (uint8_t *view : {_base, _base + _size}) {
+        if (::mmap(view, _size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd.fd_num(), 0) == MAP_FAILED) {
+            const auto error = unix_error("mmap");
+            release();
+            throw error;
+        }
+    }
+}
+
+void MirroredMemory::release() noexcept {
+    if (_base) {
+        ::munmap(_base, 2 * _size);
+        _base = nullptr;
+    }
+}
+
+MirroredMemory::MirroredMemory(MirroredMemory &&other) noexcept
+    : _base(exchange(other._base, nullptr)), _size(other._size) {}
+
+MirroredMemory &MirroredMemory::operator=(MirroredMemory &&other) noexcept {
+    if (this != &other) {
+        release();
+        _base = exchange(other._base, nullptr);
+        _size = other._size;
+    }
+    return *this;
+}
@@ -0,0 +1,48 @@
+#ifndef SPONGE_LIBSPONGE_MIRRORED_MEMORY_HH
+#define SPONGE_LIBSPONGE_MIRRORED_MEMORY_HH
+
+#include <cstddef>
+#include <cstdint>
+
+//! \brief A ring of memory that is mapped twice, back to back, in the address space
+
+//! The `size()` bytes starting at data() are mapped again at `data() + size()`, so any window
+//! of up to `size()` bytes starting inside the ring is virtually contiguous, even if it wraps.
+//! The size is rounded up to a power of two that is a multiple of the page size.
+//! Built on [memfd_create(2)](\ref man2::memfd_create) and [mmap(2)](\ref man2::mmap).
+class MirroredMemory {
+  private:
+    uint8_t *_base{nullptr};
+    size_t _size{0};
+
+    void release() noexcept;
+
+  public:
+    //! Map a ring that can hold at least `min_size` bytes
+    explicit MirroredMemory(const size_t min_size);
+
+    //! \returns the size of the ring that holds at least `min_size` bytes
+    static size_t size_for(const size_t min_size);
+
+    //! Unmap both copies of the ring
+    ~MirroredMemory() { release(); }
+
+    //! \returns the start of the first copy of the ring
+    uint8_t *data() { return _base; }
+    const uint8_t *data() const { return _base; }
+
+    //! \returns the size of one copy of the ring (a power of two)
+    size_t size() const { return _size; }
+
+    //! \name
+    //! MirroredMemory can be moved, but cannot be copied
+
+    //!@{
+    MirroredMemory(const MirroredMemory &other) = delete;
+    MirroredMemory &operator=(const MirroredMemory &other) = delete;
+    MirroredMemory(MirroredMemory &&other) noexcept;
+    MirroredMemory &operator=(MirroredMemory &&other) noexcept;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_MIRRORED_MEMORY_HH
@@ -0,0 +1,72 @@
+#include "timer_wheel.hh"
+
+#include <utility>
+
+using namespace std;
+
+void TimerWheel::insert(const Entry &entry) {
+    // the wheel is the one for the highest group of bits in which the deadline differs from now;
+    // deadlines beyond the coarsest wheel wait in its first slot, which comes up as it wraps around,
+    // and are placed again then
+    unsigned level = 0;
+    while (level + 1 < LEVELS && (entry.deadline >> (BITS * (level + 1))) != (_now >> (BITS * (level + 1)))) {
+        ++level;
+    }
+    const bool beyond = (entry.deadline >> (BITS * LEVELS)) != (_now >> (BITS * LEVELS));
+    const auto slot = beyond ? 0 : (entry.deadline >> (BITS * level)) & (SLOTS - 1);
+    _wheels[level][slot].push_back(entry);
+}
+
+void TimerWheel::cascade(const unsigned level) {
+    auto &slot = _wheels[level][(_now >> (BITS * level)) & (SLOTS - 1)];
+    auto entries = move(slot);
+    slot.clear();
+    for (const auto &entry : entries) {
+        if (_callbacks.count(entry.id)) {
+            insert(entry);
+        }
+    }
+}
+
+TimerWheel::Id TimerWheel::schedule(const uint64_t delay, function<void()> callback) {
+    const auto id = _next_id++;
+    _callbacks.emplace(id, move(callback));
+    insert({_now + max<uint64_t>(delay, 1), id});
+    return id;
+}
+
+void TimerWheel::advance(const uint64_t ms) {
+    for (uint64_t i = 0; i < ms; ++i) {
+        if (_callbacks.empty()) {
+            // nothing can fire: skip the rest, dropping what cancelled timers left behind
+            for (auto &wheel : _wheels) {
+                for (auto &slot : wheel) {
+                    slot.clear();
+                }
+            }
+            _now += ms - i;
+            return;
+        }
+        ++_now;
+        // a coarse slot comes up when all the finer bits roll over to zero
+        unsigned top = 0;
+        while (top + 1 < LEVELS && (_now & ((uint64_t{1} << (BITS * (top + 1))) - 1)) == 0) {
+            ++top;
+        }
+        for (unsigned level = top; level > 0; --level) {
+            cascade(level);
+        }
+        auto &slot = _wheels[0][_now & (SLOTS - 1)];
+        auto due = move(slot);
+        slot.clear();
+        for (const auto &entry : due) {
+            const auto it = _callbacks.find(entry.id);
+            if (it == _callbacks.end()) {
+                continue;
+            }
+            const auto callback = move(it->second);
+            _callbacks.erase(it);
+            callback();
+        }
+    }
+}
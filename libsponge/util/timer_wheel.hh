@@ -0,0 +1,116 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//! \brief A hierarchical timing wheel: many timers on one millisecond clock
+
+//! Four wheels of 64 slots each cover 1 ms, 64 ms, 4 s and 4.6 h per slot. A timer goes into the
+//! wheel whose slots are as coarse as the time to its deadline; when a coarse slot comes up, its
+//! timers move down to finer wheels, and a timer fires when its slot in the finest wheel comes up.
+//! Scheduling and cancelling take constant time, and advance() costs one step per millisecond
+//! plus a constant per timer, whatever the number of objects the timers belong to.
+class TimerWheel {
+  public:
+    using Id = uint64_t;  //!< Names a scheduled timer, for cancel()
+
+  private:
+    static constexpr unsigned BITS = 6;
+    static constexpr size_t SLOTS = size_t{1} << BITS;
+    static constexpr unsigned LEVELS = 4;
+
+    struct Entry {
+        uint64_t deadline;
+        Id id;
+    };
+
+    std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> _wheels{};
+    //! the callbacks of the timers not yet fired or cancelled; entries left in the slots by
+    //! cancel() are dropped when their slot comes up
+    std::unordered_map<Id, std::function<void()>> _callbacks{};
+    uint64_t _now{0};
+    Id _next_id{0};
+
+    void insert(const Entry &entry);
+    //! move the timers of the slot at `level` that `_now` has just reached down to finer wheels
+    void cascade(const unsigned level);
+
+  public:
+    //! \brief Call `callback` once `delay` milliseconds have passed (at the next advance(), for zero)
+    //! \returns the timer's Id
+    Id schedule(const uint64_t delay, std::function<void()> callback);
+
+    //! \brief Forget a timer that hasn't fired yet (does nothing if it has)
+    void cancel(const Id id) { _callbacks.erase(id); }
+
+    //! \brief Let `ms` milliseconds pass, firing the timers that come due, in order
+    void advance(const uint64_t ms);
+
+    //! \returns the milliseconds advanced so far
+    uint64_t now() const { return _now; }
+
+    //! \returns the number of timers waiting to fire
+    size_t size() const { return _callbacks.size(); }
+};
+
+//! \brief Ticks an object (a TCPConnection, a NetworkInterface) from a TimerWheel only when it has a timer due
+
+//! `T` must have `tick(ms)` and `next_timer()`, which returns the milliseconds until a tick() would do
+//! anything, or nothing. Between timers the object's clock lags behind the wheel's, so the owner must
+//! call catch_up() before handing it anything (a segment, a write) and rearm() after.
+template <typename T>
+class WheelTicker {
+  private:
+    TimerWheel &_wheel;
+    T &_ticked;
+    uint64_t _last_tick;
+    std::optional<TimerWheel::Id> _timer{};
+
+  public:
+    WheelTicker(TimerWheel &wheel, T &ticked) : _wheel(wheel), _ticked(ticked), _last_tick(wheel.now()) { rearm(); }
+    ~WheelTicker() { disarm(); }
+
+    //! \brief Tick the object up to the wheel's time
+    void catch_up() {
+        if (_wheel.now() > _last_tick) {
+            _ticked.tick(_wheel.now() - _last_tick);
+            _last_tick = _wheel.now();
+        }
+    }
+
+    //! \brief Schedule a tick for the object's next timer, after something may have moved it
+    void rearm() {
+        disarm();
+        if (const auto next = _ticked.next_timer()) {
+            _timer = _wheel.schedule(*next, [this] {
+                _timer.reset();
+                catch_up();
+                rearm();
+            });
+        }
+    }
+
+    //! \brief Stop ticking the object
+    void disarm() {
+        if (_timer) {
+            _wheel.cancel(*_timer);
+            _timer.reset();
+        }
+    }
+
+    //! \name
+    //! A WheelTicker's timer refers to it, so it can be neither copied nor moved
+
+    //!@{
+    WheelTicker(const WheelTicker &other) = delete;
+    WheelTicker &operator=(const WheelTicker &other) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
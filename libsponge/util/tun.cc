@@ -7,6 +7,7 @@
 #include <linux/if.h>
 #include <linux/if_tun.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 
 static constexpr const char *CLONEDEV = "/dev/net/tun";
 
@@ -22,7 +23,7 @@ using namespace std;
 //! as root before calling this function.
 
 TunTapFD::TunTapFD(const string &devname, const bool is_tun)
-    : FileDescriptor(SystemCall("open", open(CLONEDEV, O_RDWR))) {
+    : FileDescriptor(SystemCall("open", open(CLONEDEV, O_RDWR))), _devname(devname) {
     struct ifreq tun_req {};
 
     tun_req.ifr_flags = (is_tun ? IFF_TUN : IFF_TAP) | IFF_NO_PI;  // tun device with no packetinfo
@@ -34,3 +35,15 @@ TunTapFD::TunTapFD(const string &devname, const bool is_tun)
 
     SystemCall("ioctl", ioctl(fd_num(), TUNSETIFF, static_cast<void *>(&tun_req)));
 }
+
+size_t TunTapFD::mtu() const {
+    struct ifreq mtu_req {};
+
+    strncpy(static_cast<char *>(mtu_req.ifr_name), _devname.data(), IFNAMSIZ - 1);
+    mtu_req.ifr_name[IFNAMSIZ - 1] = '\0';
+
+    // SIOCGIFMTU takes any socket, not the device itself
+    FileDescriptor sock{SystemCall("socket", socket(AF_INET, SOCK_DGRAM, 0))};
+    SystemCall("ioctl", ioctl(sock.fd_num(), SIOCGIFMTU, static_cast<void *>(&mtu_req)));
+    return mtu_req.ifr_mtu;
+}
@@ -0,0 +1,63 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"chunked write-pop", 15, ByteStream::Mode::Chunked};
+
+            test.execute(Write{"cat"});
+            test.execute(Write{"tac"});
+            test.execute(BufferSize{6});
+            test.execute(Peek{"catta"});
+            test.execute(Pop{4});
+            test.execute(Peek{"ac"});
+            test.execute(BytesRead{4});
+            test.execute(RemainingCapacity{13});
+        }
+
+        {
+            ByteStreamTestHarness test{"chunked overwrite", 4, ByteStream::Mode::Chunked};
+
+            test.execute(WriteBuffer{"abc"}.with_bytes_written(3));
+            test.execute(Write{"def"}.with_bytes_written(1));
+            test.execute(WriteBuffer{"g"}.with_bytes_written(0));
+            test.execute(Peek{"abcd"});
+            test.execute(RemainingCapacity{0});
+        }
+
+        {
+            ByteStreamTestHarness test{"chunked read_buffer", 32, ByteStream::Mode::Chunked};
+
+            test.execute(WriteBuffer{"hello"});
+            test.execute(Write{" world"});
+            test.execute(ReadBuffer{"hel", 1});
+            test.execute(ReadBuffer{"lo wo", 2});
+            test.execute(BytesRead{8});
+            test.execute(BufferSize{3});
+            test.execute(EndInput{});
+            test.execute(ReadBuffer{"rld", 1});
+            test.execute(Eof{true});
+        }
+
+        {
+            ByteStreamTestHarness test{"ring read_buffer", 8};
+
+            test.execute(WriteBuffer{"hello"});
+            test.execute(Pop{3});
+            test.execute(Write{" world"}.with_bytes_written(6));
+            test.execute(ReadBuffer{"lo worl", 1});
+            test.execute(BufferSize{1});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
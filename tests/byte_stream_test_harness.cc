@@ -45,11 +45,17 @@ void ByteStreamAction::execute(ByteStream &) const {}
 
 ByteStreamAction::~ByteStreamAction() {}
 
-ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name,
+                                             const size_t capacity,
+                                             const ByteStream::Mode mode)
+    : _test_name(test_name), _byte_stream(capacity, mode) {
     std::ostringstream ss;
     ss << "Initialized with ("
-       << "capacity=" << capacity << ")";
+       << "capacity=" << capacity << ", mode="
+       << (mode == ByteStream::Mode::Chunked    ? "chunked"
+           : mode == ByteStream::Mode::Mirrored ? "mirrored"
+                                                : "ring")
+       << ")";
     _steps_executed.emplace_back(ss.str());
 }
 
@@ -97,6 +103,66 @@ void Write::execute(ByteStream &bs) const {
     }
 }
 
+// WriteBuffer
+WriteBuffer::WriteBuffer(const std::string &data) : _data(std::string(data)) {}
+WriteBuffer &WriteBuffer::with_bytes_written(const size_t bytes_written) {
+    _bytes_written = bytes_written;
+    return *this;
+}
+std::string WriteBuffer::description() const { return "write Buffer \"" + _data.copy() + "\" to the stream"; }
+void WriteBuffer::execute(ByteStream &bs) const {
+    auto bytes_written = bs.write(_data);
+    if (_bytes_written and bytes_written != _bytes_written.value()) {
+        throw ByteStreamExpectationViolation::property("bytes_written", _bytes_written.value(), bytes_written);
+    }
+}
+
+// WriteSpans
+WriteSpans::WriteSpans(const std::string &data) : _data(data) {}
+std::string WriteSpans::description() const { return "write \"" + _data + "\" through writable_spans"; }
+void WriteSpans::execute(ByteStream &bs) const {
+    size_t written = 0;
+    for (const auto &span : bs.writable_spans()) {
+        const auto len = min(span.iov_len, _data.size() - written);
+        _data.copy(static_cast<char *>(span.iov_base), len, written);
+        written += len;
+    }
+    if (written != _data.size()) {
+        throw ByteStreamExpectationViolation::property("writable span size", _data.size(), written);
+    }
+    bs.commit_write(written);
+}
+
+// ReadBuffer
+ReadBuffer::ReadBuffer(const std::string &output, const size_t buffers) : _output(output), _buffers(buffers) {}
+std::string ReadBuffer::description() const {
+    return "read_buffer \"" + _output + "\" in " + to_string(_buffers) + " buffer(s)";
+}
+void ReadBuffer::execute(ByteStream &bs) const {
+    auto output = bs.read_buffer(_output.size());
+    if (output.concatenate() != _output) {
+        throw ByteStreamExpectationViolation("Expected \"" + _output + "\" at the front of the stream, but found \"" +
+                                             output.concatenate() + "\"");
+    }
+    if (output.buffers().size() != _buffers) {
+        throw ByteStreamExpectationViolation::property("buffer count", _buffers, output.buffers().size());
+    }
+}
+
+// PeekView
+PeekView::PeekView(const std::string &first, const std::string &second) : _first(first), _second(second) {}
+std::string PeekView::description() const {
+    return "views \"" + _first + "\" and \"" + _second + "\" at the front of the stream";
+}
+void PeekView::execute(ByteStream &bs) const {
+    const auto views = bs.peek_view(_first.size() + _second.size());
+    if (views[0] != _first or views[1] != _second) {
+        throw ByteStreamExpectationViolation("Expected views \"" + _first + "\" and \"" + _second +
+                                             "\", but found \"" + string(views[0]) + "\" and \"" +
+                                             string(views[1]) + "\"");
+    }
+}
+
 // Pop
 Pop::Pop(const size_t len) : _len(len) {}
 std::string Pop::description() const { return "pop " + to_string(_len); }
@@ -56,6 +56,24 @@ struct Write : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+struct WriteBuffer : public ByteStreamAction {
+    Buffer _data;
+    std::optional<size_t> _bytes_written{};
+
+    WriteBuffer(const std::string &data);
+    WriteBuffer &with_bytes_written(const size_t bytes_written);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
+struct WriteSpans : public ByteStreamAction {
+    std::string _data;
+
+    WriteSpans(const std::string &data);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct Pop : public ByteStreamAction {
     size_t _len;
 
@@ -128,13 +146,33 @@ struct Peek : public ByteStreamExpectation {
     void execute(ByteStream &) const override;
 };
 
+struct ReadBuffer : public ByteStreamAction {
+    std::string _output;
+    size_t _buffers;
+
+    ReadBuffer(const std::string &output, const size_t buffers);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
+struct PeekView : public ByteStreamExpectation {
+    std::string _first;
+    std::string _second;
+
+    PeekView(const std::string &first, const std::string &second = "");
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 class ByteStreamTestHarness {
     std::string _test_name;
     ByteStream _byte_stream;
     std::vector<std::string> _steps_executed{};
 
   public:
-    ByteStreamTestHarness(const std::string &test_name, const size_t capacity);
+    ByteStreamTestHarness(const std::string &test_name,
+                          const size_t capacity,
+                          const ByteStream::Mode mode = ByteStream::Mode::Ring);
 
     void execute(const ByteStreamTestStep &step);
 };
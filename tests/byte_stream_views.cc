@@ -0,0 +1,81 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"peek_view contiguous", 8};
+
+            test.execute(Write{"abcde"});
+            test.execute(PeekView{"abcde"});
+            test.execute(PeekView{"abc"});
+            test.execute(Pop{2});
+            test.execute(PeekView{"cde"});
+        }
+
+        {
+            ByteStreamTestHarness test{"peek_view wrapped", 8};
+
+            test.execute(Write{"abcdef"});
+            test.execute(Pop{5});
+            test.execute(Write{"ghijk"});
+            test.execute(PeekView{"fgh", "ijk"});
+            test.execute(PeekView{"fg"});
+            test.execute(Peek{"fghijk"});
+        }
+
+        {
+            ByteStreamTestHarness test{"writable_spans", 8};
+
+            test.execute(WriteSpans{"abcdef"});
+            test.execute(BytesWritten{6});
+            test.execute(Pop{5});
+            test.execute(WriteSpans{"ghijklm"});
+            test.execute(RemainingCapacity{0});
+            test.execute(PeekView{"fgh", "ijklm"});
+            test.execute(Pop{4});
+            test.execute(WriteSpans{"nop"});
+            test.execute(Peek{"jklmnop"});
+        }
+
+        {
+            // a 5-byte stream still gets a whole page, mirrored; wrapped bytes come back as one view
+            ByteStreamTestHarness test{"peek_view mirrored", 5, ByteStream::Mode::Mirrored};
+            const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+            for (size_t written = 0; written + 5 <= page; written += 5) {
+                test.execute(Write{"abcde"});
+                test.execute(Pop{5});
+            }
+            test.execute(Write{"abcde"});
+            test.execute(RemainingCapacity{0});
+            test.execute(PeekView{"abcde"});
+            test.execute(Pop{2});
+            test.execute(WriteSpans{"fg"});
+            test.execute(PeekView{"cdefg"});
+            test.execute(Peek{"cdefg"});
+        }
+
+        {
+            ByteStreamTestHarness test{"peek_view chunked", 16, ByteStream::Mode::Chunked};
+
+            test.execute(Write{"abc"});
+            test.execute(Write{"def"});
+            test.execute(Write{"ghi"});
+            test.execute(PeekView{"abc", "de"});
+            test.execute(Pop{4});
+            test.execute(PeekView{"ef", "ghi"});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "fsm_segments.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! a data segment from the client, `offset` bytes into its stream
+static TCPSegment data(const TCPSegment &syn, const uint32_t offset, const size_t size) {
+    TCPSegment seg;
+    seg.header().seqno = syn.header().seqno + 1 + offset;
+    seg.payload() = string(size, 'x');
+    return seg;
+}
+
+int main() {
+    try {
+        TCPConfig cfg;
+        cfg.delayed_ack = true;
+
+        // the server's side of an established connection, and the client's SYN it answered
+        const auto establish = [&](TCPConnection &server, const TCPConfig &client_cfg = {}) {
+            TCPConnection client{client_cfg};
+            client.connect();
+            const auto syn = pop(client);
+            server.segment_received(syn);
+            client.segment_received(pop(server));
+            server.segment_received(pop(client));
+            // the handshake's final ACK needs no answer
+            test_should_be(server.segments_out().empty(), true);
+            return syn;
+        };
+
+        {
+            TCPConnection server{cfg};
+            const auto syn = establish(server);
+            server.segment_received(data(syn, 0, 1000));
+            // one segment's ACK should wait
+            test_should_be(server.segments_out().empty(), true);
+            server.segment_received(data(syn, 1000, 1000));
+            const auto ack = pop(server);
+            // a second full segment should draw one ACK for both
+            test_should_be(ack.header().ack, true);
+            test_should_be(ack.header().ackno, syn.header().seqno + 2001);
+            // only one ACK should go out
+            test_should_be(server.segments_out().empty(), true);
+        }
+
+        {
+            // full-sized means the MSS we offered, even if the peer's MSS keeps ours lower
+            TCPConfig server_cfg = cfg, client_cfg;
+            server_cfg.mss = 1460;
+            client_cfg.mss = 536;
+            TCPConnection server{server_cfg};
+            const auto syn = establish(server, client_cfg);
+            test_should_be(server.sender().max_segment_size(), 536u);
+            server.segment_received(data(syn, 0, 1460));
+            // one full segment's ACK should wait
+            test_should_be(server.segments_out().empty(), true);
+            server.segment_received(data(syn, 1460, 1460));
+            // a second should draw the ACK
+            test_should_be(pop(server).header().ackno, syn.header().seqno + 2921);
+        }
+
+        {
+            TCPConnection server{cfg};
+            const auto syn = establish(server);
+            server.segment_received(data(syn, 0, 100));
+            // the ACK should be due in 40 ms
+            test_should_be(server.next_send_time(), uint64_t{TCPConfig::ACK_DELAY_DFLT});
+            server.tick(39);
+            // the ACK should wait out its delay
+            test_should_be(server.segments_out().empty(), true);
+            // the ACK should be due in 1 ms
+            test_should_be(server.next_send_time(), 1u);
+            server.tick(1);
+            // the delay should end in an ACK
+            test_should_be(pop(server).header().ackno, syn.header().seqno + 101);
+            // nothing should be due after the ACK
+            test_should_be(server.next_send_time().has_value(), false);
+        }
+
+        {
+            TCPConnection server{cfg};
+            const auto syn = establish(server);
+            server.segment_received(data(syn, 1000, 1000));
+            // an out-of-order segment should draw an ACK
+            test_should_be(pop(server).header().ackno, syn.header().seqno + 1);
+            server.segment_received(data(syn, 0, 1000));
+            // filling the hole should draw an ACK
+            test_should_be(pop(server).header().ackno, syn.header().seqno + 2001);
+            server.segment_received(data(syn, 0, 1000));
+            // a duplicate should draw an ACK
+            test_should_be(pop(server).header().ackno, syn.header().seqno + 2001);
+        }
+
+        {
+            TCPConnection server{cfg};
+            const auto syn = establish(server);
+            server.segment_received(data(syn, 0, 500));
+            server.write("reply");
+            const auto reply = pop(server);
+            // data sent meanwhile should carry the ACK
+            test_should_be(reply.payload().size(), 5u);
+            test_should_be(reply.header().ackno, syn.header().seqno + 501);
+            server.tick(TCPConfig::ACK_DELAY_DFLT);
+            // no ACK should follow the one the data carried
+            test_should_be(server.segments_out().empty(), true);
+        }
+
+        {
+            TCPConnection server{cfg};
+            const auto syn = establish(server);
+            auto fin = data(syn, 0, 500);
+            fin.header().fin = true;
+            server.segment_received(fin);
+            // a FIN should be ACKed at once
+            test_should_be(pop(server).header().ackno, syn.header().seqno + 502);
+        }
+
+        {
+            TCPConnection server{TCPConfig{}};
+            const auto syn = establish(server);
+            server.segment_received(data(syn, 0, 1000));
+            // without delayed ACKs, every segment is ACKed
+            test_should_be(pop(server).header().ackno, syn.header().seqno + 1001);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
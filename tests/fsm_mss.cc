@@ -0,0 +1,97 @@
+#include "congestion_control.hh"
+#include "fsm_segments.hh"
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // the MSS option survives serialization, ahead of the others
+            TCPHeader header;
+            header.syn = true;
+            header.options.mss = 8960;
+            header.options.sack_permitted = true;
+            header.options.window_scale = 2;
+            TCPHeader parsed;
+            NetParser p{header.serialize()};
+            // the header should parse
+            test_should_be(parsed.parse(p) == ParseResult::NoError, true);
+            // the options should round-trip
+            test_should_be(parsed.options == header.options, true);
+        }
+
+        {
+            // without an MSS configured, the SYN offers the default
+            TCPConnection conn{TCPConfig{}};
+            conn.connect();
+            // the SYN should offer the default MSS
+            test_should_be(pop(conn).header().options.mss, TCPConfig::MAX_PAYLOAD_SIZE);
+        }
+
+        {
+            // each end sends at most the smaller of the two MSSes
+            TCPConfig client_cfg, server_cfg;
+            client_cfg.mss = 8960;
+            client_cfg.congestion_control = CongestionAlgorithm::NewReno;
+            server_cfg.mss = 536;
+            TCPConnection client{client_cfg}, server{server_cfg};
+            client.connect();
+            const auto syn = pop(client);
+            // the client's SYN should offer its MSS
+            test_should_be(syn.header().options.mss, 8960);
+            server.segment_received(syn);
+            const auto syn_ack = pop(server);
+            // the server's SYN/ACK should offer its MSS
+            test_should_be(syn_ack.header().options.mss, 536);
+            client.segment_received(syn_ack);
+            server.segment_received(pop(client));
+            // both ends should send at most 536 bytes
+            test_should_be(client.sender().max_segment_size(), 536u);
+            test_should_be(server.sender().max_segment_size(), 536u);
+            // the initial window should follow the MSS
+            test_should_be(client.sender().congestion_control()->cwnd(), CongestionControl::initial_window(536));
+
+            client.write(string(2000, 'x'));
+            const auto first = pop(client);
+            // the client's segments should shrink to the server's MSS
+            test_should_be(first.payload().size(), 536u);
+
+            server.write(string(2000, 'x'));
+            // the server's segments should keep to its own MSS
+            test_should_be(pop(server).payload().size(), 536u);
+        }
+
+        {
+            // a larger MSS means fewer, larger segments
+            TCPConfig cfg;
+            cfg.mss = 4000;
+            TCPConnection client{cfg}, server{cfg};
+            client.connect();
+            server.segment_received(pop(client));
+            client.segment_received(pop(server));
+            server.segment_received(pop(client));
+            client.write(string(10000, 'x'));
+            // 10000 bytes should take three segments
+            test_should_be(client.segments_out().size(), 3u);
+            // segments should fill the MSS
+            test_should_be(pop(client).payload().size(), 4000u);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+#include "fsm_segments.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! the peer's ACK of everything `sent` so far
+static TCPSegment ack(const TCPSegment &sent) {
+    TCPSegment seg;
+    seg.header().ack = true;
+    seg.header().ackno = sent.header().seqno + sent.length_in_sequence_space();
+    seg.header().win = 60000;
+    return seg;
+}
+
+int main() {
+    try {
+        TCPConfig cfg;
+        cfg.nagle = true;
+
+        // the client's side of an established connection, and the peer's SYN-ACK
+        const auto establish = [](TCPConnection &client) {
+            TCPConnection server{TCPConfig{}};
+            client.connect();
+            server.segment_received(pop(client));
+            const auto syn_ack = pop(server);
+            client.segment_received(syn_ack);
+            pop(client);
+            return syn_ack;
+        };
+
+        {
+            TCPConnection client{cfg};
+            const auto syn_ack = establish(client);
+            client.write("first");
+            const auto first = pop(client);
+            // nothing in flight: a short segment should go at once
+            test_should_be(first.payload().copy(), "first"s);
+            client.write("second");
+            client.write("third");
+            // Nagle should hold short segments while data is in flight
+            test_should_be(client.segments_out().empty(), true);
+            auto first_ack = ack(first);
+            first_ack.header().seqno = syn_ack.header().seqno + 1;
+            client.segment_received(first_ack);
+            // the ACK should let the writes go together
+            test_should_be(pop(client).payload().copy(), "secondthird"s);
+            // the writes should share one segment
+            test_should_be(client.segments_out().empty(), true);
+        }
+
+        {
+            TCPConnection client{cfg};
+            establish(client);
+            client.write("first");
+            pop(client);
+            client.write(string(2500, 'x'));
+            // full segments should still go out
+            test_should_be(pop(client).payload().size(), TCPConfig::MAX_PAYLOAD_SIZE);
+            // full segments should still go out
+            test_should_be(pop(client).payload().size(), TCPConfig::MAX_PAYLOAD_SIZE);
+            // the short tail should wait
+            test_should_be(client.segments_out().empty(), true);
+            client.end_input_stream();
+            const auto fin = pop(client);
+            // closing the stream should send the tail with the FIN
+            test_should_be(fin.header().fin, true);
+            test_should_be(fin.payload().size(), 2500 - 2 * TCPConfig::MAX_PAYLOAD_SIZE);
+        }
+
+        {
+            TCPConnection client{cfg};
+            establish(client);
+            client.write("first");
+            pop(client);
+            client.write("second");
+            // Nagle should hold the second write
+            test_should_be(client.segments_out().empty(), true);
+            client.set_nodelay(true);
+            // turning Nagle off should send what it held
+            test_should_be(pop(client).payload().copy(), "second"s);
+            client.write("third");
+            // without Nagle, short segments go at once
+            test_should_be(pop(client).payload().copy(), "third"s);
+        }
+
+        {
+            TCPConnection client{TCPConfig{}};
+            establish(client);
+            client.cork();
+            client.write("one");
+            client.write("two");
+            // a corked connection should hold short segments
+            test_should_be(client.segments_out().empty(), true);
+            client.uncork();
+            // uncorking should send the writes in one segment
+            test_should_be(pop(client).payload().copy(), "onetwo"s);
+        }
+
+        {
+            TCPConnection client{TCPConfig{}};
+            client.cork();
+            client.uncork();
+            client.set_nodelay(true);
+            // uncorking shouldn't open the connection
+            test_should_be(client.segments_out().empty(), true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+#include "congestion_control.hh"
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static TCPSegment data_segment(const WrappingInt32 seqno, const size_t size) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.payload() = string(size, 'x');
+    return seg;
+}
+
+//! \returns the sequence numbers of the segments the sender queued, emptying its queue
+static vector<uint32_t> drain(TCPSender &sender) {
+    vector<uint32_t> seqnos;
+    while (not sender.segments_out().empty()) {
+        seqnos.push_back(sender.segments_out().front().header().seqno.raw_value());
+        sender.segments_out().pop();
+    }
+    return seqnos;
+}
+
+//! a sender with eight 1000-byte segments in flight, from sequence numbers 1 to 8001
+static void fill(TCPSender &sender, const bool peer_offers_sack) {
+    sender.fill_window();
+    // the SYN should offer SACK
+    test_should_be(sender.segments_out().front().header().options.sack_permitted, true);
+    TCPOptions peer;
+    peer.sack_permitted = peer_offers_sack;
+    sender.peer_syn_options(peer);
+    sender.ack_received(WrappingInt32{1}, 60000);
+    sender.stream_in().write(string(8000, 'x'));
+    sender.fill_window();
+    drain(sender);
+}
+
+int main() {
+    try {
+        {
+            // options survive serialization, and as many SACK blocks as fit are kept
+            TCPHeader header;
+            header.options.sack_permitted = true;
+            for (uint32_t i = 0; i < 5; ++i) {
+                header.options.sack.push_back({WrappingInt32{1000 * i}, WrappingInt32{1000 * i + 500}});
+            }
+            TCPHeader parsed;
+            NetParser p{header.serialize()};
+            // a header with options should parse
+            test_should_be(parsed.parse(p) == ParseResult::NoError, true);
+            // the options should take 40 bytes
+            test_should_be(parsed.doff, 15);
+            test_should_be(header.serialized_length(), 60u);
+            // the SACK blocks should round-trip
+            test_should_be(parsed.options.sack_permitted, true);
+            test_should_be(parsed.options.sack.size(), TCPOptions::MAX_SACK_BLOCKS);
+            test_should_be(parsed.options.sack.back() == header.options.sack[3], true);
+
+            // unknown options (MSS, window scale) are skipped
+            TCPHeader plain;
+            plain.doff = 8;
+            string raw = plain.serialize();
+            const string options = {2, 4, 5, char(0xb4), 1, 3, 3, 7, 4, 2, 0, 0};
+            raw.replace(TCPHeader::LENGTH, options.size(), options);
+            NetParser q{string(raw)};
+            // unknown options should be skipped
+            test_should_be(parsed.parse(q) == ParseResult::NoError, true);
+            test_should_be(parsed.options.sack_permitted, true);
+            test_should_be(parsed.options.sack.empty(), true);
+
+            // a truncated option ends the options without failing the parse
+            raw.replace(TCPHeader::LENGTH, 4, string{4, 2, 5, 30});
+            NetParser r{string(raw)};
+            // a malformed option should be ignored
+            test_should_be(parsed.parse(r) == ParseResult::NoError, true);
+            test_should_be(parsed.options.sack.empty(), true);
+        }
+
+        {
+            // the first block holds the latest out-of-order segment, then the rest from the lowest up
+            const WrappingInt32 isn{0x7fff'fff0};
+            TCPReceiver receiver{10000};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = isn;
+            receiver.segment_received(syn);
+            // nothing out of order, nothing to SACK
+            test_should_be(receiver.sack_blocks(4).empty(), true);
+
+            receiver.segment_received(data_segment(isn + 1 + 1000, 1000));
+            receiver.segment_received(data_segment(isn + 1 + 5000, 1000));
+            receiver.segment_received(data_segment(isn + 1 + 3000, 500));
+            receiver.segment_received(data_segment(isn + 1 + 3500, 500));
+            const auto blocks = receiver.sack_blocks(4);
+            // the block with the latest segment should come first, then the others from the lowest up
+            test_should_be(blocks.size(), 3u);
+            test_should_be((blocks[0] == SackBlock{isn + 3001, isn + 4001}), true);
+            test_should_be((blocks[1] == SackBlock{isn + 1001, isn + 2001}), true);
+            test_should_be((blocks[2] == SackBlock{isn + 5001, isn + 6001}), true);
+            // the number of blocks should be capped
+            test_should_be(receiver.sack_blocks(2).size(), 2u);
+
+            receiver.segment_received(data_segment(isn + 1, 1000));
+            // assembled bytes should leave the SACK blocks
+            test_should_be(receiver.sack_blocks(4).size(), 2u);
+        }
+
+        TCPConfig cfg;
+        cfg.fixed_isn = WrappingInt32{0};
+        cfg.fast_retransmit = true;
+        cfg.sack = true;
+
+        {
+            // the segments at 1 and 3001 are lost: SACK recovery resends both at once
+            TCPSender sender{cfg};
+            fill(sender, true);
+            // both ends offered SACK
+            test_should_be(sender.sack_enabled(), true);
+            const vector<SackBlock> first{{WrappingInt32{1001}, WrappingInt32{3001}}};
+            const vector<SackBlock> later{{WrappingInt32{4001}, WrappingInt32{8001}},
+                                          {WrappingInt32{1001}, WrappingInt32{3001}}};
+            sender.sack_received(first);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.sack_received(first);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            // two duplicates shouldn't resend anything
+            test_should_be(drain(sender).empty(), true);
+            sender.sack_received(later);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            // SACK recovery should resend exactly the holes
+            test_should_be((drain(sender) == vector<uint32_t>{1, 3001}), true);
+
+            sender.sack_received({{WrappingInt32{4001}, WrappingInt32{8001}}});
+            sender.ack_received(WrappingInt32{3001}, 60000);
+            // a partial ack shouldn't resend a hole again
+            test_should_be(drain(sender).empty(), true);
+            sender.ack_received(WrappingInt32{8001}, 60000);
+            // only the two lost segments should be resent
+            test_should_be(sender.retransmitted_bytes(), 2000u);
+            test_should_be(sender.fast_retransmissions(), 2u);
+        }
+
+        {
+            // after an RTO, slow start resends every hole the SACK blocks show, not one per RTO
+            TCPConfig rto_cfg = cfg;
+            rto_cfg.congestion_control = CongestionAlgorithm::NewReno;
+            rto_cfg.mss = 1000;
+            TCPSender sender{rto_cfg};
+            sender.fill_window();
+            TCPOptions peer;
+            peer.sack_permitted = true;
+            sender.peer_syn_options(peer);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(4000, 'x'));
+            sender.fill_window();
+            for (uint32_t ackno = 1001; ackno <= 4001; ackno += 1000) {
+                sender.ack_received(WrappingInt32{ackno}, 60000);
+            }
+            drain(sender);
+            sender.stream_in().write(string(8000, 'x'));
+            sender.fill_window();
+            // slow start should have opened the window to eight segments
+            test_should_be(drain(sender).size(), 8u);
+
+            // the segments at 4001, 6001 and 8001 are lost, and the RTO fires before a third duplicate
+            const vector<SackBlock> blocks{{WrappingInt32{5001}, WrappingInt32{6001}},
+                                           {WrappingInt32{7001}, WrappingInt32{8001}},
+                                           {WrappingInt32{9001}, WrappingInt32{12001}}};
+            sender.sack_received(blocks);
+            sender.ack_received(WrappingInt32{4001}, 60000);
+            sender.tick(rto_cfg.rt_timeout);
+            // the RTO should resend the first hole
+            test_should_be((drain(sender) == vector<uint32_t>{4001}), true);
+
+            sender.sack_received({blocks[1], blocks[2]});
+            sender.ack_received(WrappingInt32{6001}, 60000);
+            // the ACK of the first hole should let the other two out at once
+            test_should_be((drain(sender) == vector<uint32_t>{6001, 8001}), true);
+            sender.ack_received(WrappingInt32{12001}, 60000);
+            // only the holes should be resent, and not by fast retransmit
+            test_should_be(sender.retransmitted_bytes(), 3000u);
+            test_should_be(sender.fast_retransmissions(), 0u);
+        }
+
+        {
+            // without SACK, the second hole only shows once the first is repaired
+            TCPSender sender{cfg};
+            fill(sender, false);
+            // the peer didn't offer SACK
+            test_should_be(sender.sack_enabled(), false);
+            for (unsigned i = 0; i < 3; ++i) {
+                sender.sack_received({{WrappingInt32{1001}, WrappingInt32{3001}}});
+                sender.ack_received(WrappingInt32{1}, 60000);
+            }
+            // NewReno should resend only the first hole
+            test_should_be(drain(sender) == vector<uint32_t>{1}, true);
+            sender.ack_received(WrappingInt32{3001}, 60000);
+            // NewReno should resend the next hole on a partial ack
+            test_should_be(drain(sender) == vector<uint32_t>{3001}, true);
+        }
+
+        {
+            // SACK is only used when both ends offer it, and the receiver then reports its blocks
+            for (const bool server_offers : {true, false}) {
+                TCPConfig server_cfg = cfg;
+                server_cfg.sack = server_offers;
+                TCPConnection client{cfg}, server{server_cfg};
+                client.connect();
+                const auto syn = client.segments_out().front();
+                client.segments_out().pop();
+                server.segment_received(syn);
+                const auto syn_ack = server.segments_out().front();
+                server.segments_out().pop();
+                // the SYN/ACK should answer the offer
+                test_should_be(syn_ack.header().options.sack_permitted, server_offers);
+                client.segment_received(syn_ack);
+                // both ends should agree on SACK
+                test_should_be(client.sender().sack_enabled(), server_offers);
+                test_should_be(server.sender().sack_enabled(), server_offers);
+                while (not client.segments_out().empty()) {
+                    client.segments_out().pop();
+                }
+
+                client.write(string(3000, 'x'));
+                queue<TCPSegment> data;
+                swap(data, client.segments_out());
+                data.pop();  // the first segment is lost
+                server.segment_received(data.front());
+                const auto &dupack = server.segments_out().back().header();
+                // the server should still ack the SYN only
+                test_should_be(dupack.ackno, syn.header().seqno + 1);
+                // the server should SACK what it holds
+                test_should_be(dupack.options.sack.size(), server_offers ? 1u : 0);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
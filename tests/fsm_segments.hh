@@ -0,0 +1,17 @@
+#ifndef SPONGE_TESTS_FSM_SEGMENTS_HH
+#define SPONGE_TESTS_FSM_SEGMENTS_HH
+
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+//! \returns the oldest segment the connection has sent, taking it off its queue
+static TCPSegment pop(TCPConnection &conn) {
+    // the connection should have sent a segment
+    test_should_be(conn.segments_out().empty(), false);
+    auto seg = conn.segments_out().front();
+    conn.segments_out().pop();
+    return seg;
+}
+
+#endif  // SPONGE_TESTS_FSM_SEGMENTS_HH
@@ -0,0 +1,130 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+//! \param mode how the output of the backend under test holds the assembled bytes, in the randomized comparison
+static void test_backend(const StreamReassembler::Backend backend,
+                         const ByteStream::Mode mode = ByteStream::Mode::Ring) {
+    {
+        ReassemblerTestHarness test{65000, backend};
+
+        test.execute(SubmitSegment{"b", 1});
+        test.execute(SubmitSegment{"d", 3});
+        test.execute(UnassembledBytes(2));
+        test.execute(UnassembledHoles(2, 2));
+        test.execute(SubmitSegment{"abc", 0});
+        test.execute(UnassembledBytes(0));
+        test.execute(BytesAssembled(4));
+        test.execute(BytesAvailable("abcd"));
+    }
+
+    {
+        ReassemblerTestHarness test{65000, backend};
+
+        test.execute(SubmitSegment{"cd", 2});
+        test.execute(SubmitSegment{"ef", 4});
+        test.execute(SubmitSegment{"def", 3});
+        test.execute(UnassembledBytes(4));
+        test.execute(SubmitSegment{"h", 7}.with_eof(true));
+        test.execute(UnassembledBytes(5));
+        test.execute(SubmitSegment{"ab", 0});
+        test.execute(BytesAvailable("abcdef"));
+        test.execute(NotAtEof{});
+        test.execute(SubmitSegment{"g", 6});
+        test.execute(BytesAvailable("gh"));
+        test.execute(AtEof{});
+    }
+
+    {
+        // the window slides over the end of the ring while bytes are held out of order
+        ReassemblerTestHarness test{8, backend};
+
+        test.execute(SubmitSegment{"abcdef", 0});
+        test.execute(BytesAvailable("abcdef"));
+        test.execute(SubmitSegment{"jklmnoXX", 9});
+        test.execute(UnassembledBytes(5));
+        test.execute(SubmitSegment{"ghi", 6});
+        test.execute(BytesAssembled(14));
+        test.execute(BytesAvailable("ghijklmn"));
+        test.execute(SubmitSegment{"nop", 13}.with_eof(true));
+        test.execute(BytesAvailable("op"));
+        test.execute(AtEof{});
+    }
+
+    {
+        // an eof beyond the window is forgotten, like the bytes that carried it
+        ReassemblerTestHarness test{2, backend};
+
+        test.execute(SubmitSegment{"abc", 0}.with_eof(true));
+        test.execute(BytesAvailable("ab"));
+        test.execute(NotAtEof{});
+        test.execute(SubmitSegment{"c", 2}.with_eof(true));
+        test.execute(BytesAvailable("c"));
+        test.execute(AtEof{});
+    }
+
+    // the queue and this backend assemble the same stream from the same shuffled, overlapping segments
+    auto rd = get_random_generator();
+    for (unsigned rep_no = 0; rep_no < 32; ++rep_no) {
+        const size_t capacity = 4096;
+        StreamReassembler queue{capacity}, other{capacity, backend, mode};
+
+        string d(4 * capacity, 0);
+        generate(d.begin(), d.end(), [&] { return rd(); });
+
+        string queue_out, other_out;
+        while (other_out.size() < d.size()) {
+            vector<tuple<size_t, size_t>> segs;
+            for (unsigned i = 0; i < 64; ++i) {
+                const size_t off = other_out.size() + rd() % capacity;
+                segs.emplace_back(off, min<size_t>(1 + rd() % 256, d.size() - min(off, d.size())));
+            }
+            segs.emplace_back(other_out.size(), min<size_t>(256, d.size() - other_out.size()));
+            shuffle(segs.begin(), segs.end(), rd);
+
+            for (auto [off, sz] : segs) {
+                const auto seg = d.substr(min(off, d.size()), sz);
+                const bool eof = off + sz == d.size();
+                queue.push_substring(seg, off, eof);
+                other.push_substring(seg, off, eof);
+                if (queue.unassembled_bytes() != other.unassembled_bytes() ||
+                    queue.unassembled_holes() != other.unassembled_holes() ||
+                    queue.contiguous_end() != other.contiguous_end()) {
+                    throw runtime_error("hole accounting differs between the backends");
+                }
+            }
+            queue_out += queue.stream_out().read(queue.stream_out().buffer_size());
+            other_out += other.stream_out().read(other.stream_out().buffer_size());
+            if (queue_out != other_out || other_out != d.substr(0, other_out.size())) {
+                throw runtime_error("content of RX bytes is incorrect");
+            }
+        }
+        if (!other.stream_out().eof() || !other.empty()) {
+            throw runtime_error("backend did not reach eof");
+        }
+    }
+}
+
+int main() {
+    try {
+        test_backend(StreamReassembler::Backend::Ring);
+        test_backend(StreamReassembler::Backend::Ring, ByteStream::Mode::Mirrored);
+        test_backend(StreamReassembler::Backend::Slab);
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
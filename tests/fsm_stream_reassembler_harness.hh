@@ -103,6 +103,28 @@ struct UnassembledBytes : public ReassemblerExpectation {
     }
 };
 
+struct UnassembledHoles : public ReassemblerExpectation {
+    size_t _holes;
+    uint64_t _contiguous_end;
+
+    UnassembledHoles(size_t holes, uint64_t contiguous_end) : _holes(holes), _contiguous_end(contiguous_end) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "holes = " << _holes << ", contiguous end = " << _contiguous_end;
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        if (reassembler.unassembled_holes() != _holes || reassembler.contiguous_end() != _contiguous_end) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to have `" << _holes << "` holes and a contiguous end of `"
+               << _contiguous_end << "`, but there were `" << reassembler.unassembled_holes() << "` and `"
+               << reassembler.contiguous_end() << "`";
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct AtEof : public ReassemblerExpectation {
     AtEof() {}
     std::string description() const {
@@ -164,8 +186,14 @@ class ReassemblerTestHarness {
     std::vector<std::string> steps_executed;
 
   public:
-    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity), steps_executed() {
-        steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ")");
+    ReassemblerTestHarness(const size_t capacity,
+                           const StreamReassembler::Backend backend = StreamReassembler::Backend::Queue)
+        : reassembler(capacity, backend), steps_executed() {
+        const std::string name = backend == StreamReassembler::Backend::Ring   ? "ring"
+                                 : backend == StreamReassembler::Backend::Slab ? "slab"
+                                                                               : "queue";
+        steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ", backend = " + name +
+                                    ")");
     }
 
     void execute(const ReassemblerTestStep &step) {
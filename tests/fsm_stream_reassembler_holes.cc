@@ -131,6 +131,28 @@ int main() {
             test.execute(BytesAvailable(""));
             test.execute(AtEof{});
         }
+
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(UnassembledHoles(0, 0));
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(SubmitSegment{"gh", 6});
+            test.execute(UnassembledBytes(4));
+            test.execute(UnassembledHoles(2, 4));
+
+            test.execute(SubmitSegment{"ef", 4});
+            test.execute(UnassembledBytes(6));
+            test.execute(UnassembledHoles(1, 8));
+
+            test.execute(SubmitSegment{"def", 3});
+            test.execute(UnassembledBytes(6));
+
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(BytesAssembled(8));
+            test.execute(UnassembledBytes(0));
+            test.execute(UnassembledHoles(0, 8));
+        }
     } catch (const exception &e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
@@ -0,0 +1,63 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// reassemble out-of-order segments across the 4 GiB boundary, where 32-bit indices wrap around
+static void test_backend(const StreamReassembler::Backend backend) {
+    constexpr size_t chunk = 1 << 20;
+    constexpr uint64_t boundary = uint64_t(1) << 32;
+    StreamReassembler reassembler{chunk, backend};
+    auto &output = reassembler.stream_out();
+
+    // fill up to just below the boundary, reading as we go
+    const string filler(chunk, 'x');
+    while (output.bytes_written() + chunk <= boundary - 6) {
+        reassembler.push_substring(string_view(filler), output.bytes_written(), false);
+        output.commit_read(output.buffer_size());
+    }
+    const auto gap = boundary - 6 - output.bytes_written();
+    reassembler.push_substring(string_view(filler).substr(0, gap), output.bytes_written(), false);
+    output.commit_read(output.buffer_size());
+
+    // "ij" lands past the boundary, "efgh" straddles it, and "d" ends just below it
+    reassembler.push_substring(string("ij"), boundary + 2, true);
+    reassembler.push_substring(string("efgh"), boundary - 2, false);
+    if (reassembler.unassembled_bytes() != 6 || reassembler.contiguous_end() != boundary + 4) {
+        throw runtime_error("a segment straddling 4 GiB was misplaced");
+    }
+    reassembler.push_substring(string("d"), boundary - 3, false);
+    if (reassembler.unassembled_bytes() != 7 || reassembler.contiguous_end() != boundary + 4) {
+        throw runtime_error("out-of-order bytes past 4 GiB were misplaced");
+    }
+    reassembler.push_substring(string("abc"), boundary - 6, false);
+
+    if (output.bytes_written() != boundary + 4 || !output.input_ended()) {
+        throw runtime_error("stream did not reach the end past 4 GiB");
+    }
+    if (output.read(10) != "abcdefghij" || !output.eof()) {
+        throw runtime_error("content of RX bytes past 4 GiB is incorrect");
+    }
+}
+
+int main() {
+    try {
+        test_backend(StreamReassembler::Backend::Queue);
+        test_backend(StreamReassembler::Backend::Ring);
+        test_backend(StreamReassembler::Backend::Slab);
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -8,6 +8,7 @@
 #include <exception>
 #include <iostream>
 #include <stdexcept>
+#include <string_view>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -116,6 +117,40 @@ int main() {
                 throw runtime_error("test 4 - content of RX bytes is incorrect after 2nd read");
             }
         }
+
+        // same as test 1, through the string_view and Buffer overloads
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            StreamReassembler buf{MAX_SEG_LEN * NSEGS};
+
+            vector<tuple<size_t, size_t>> seq_size;
+            size_t offset = 0;
+            for (unsigned i = 0; i < NSEGS; ++i) {
+                const size_t size = 1 + (rd() % (MAX_SEG_LEN - 1));
+                seq_size.emplace_back(offset, size);
+                offset += size;
+            }
+            // keep the first half in order, so it takes the path that bypasses the queue
+            shuffle(seq_size.begin() + NSEGS / 2, seq_size.end(), rd);
+
+            string d(offset, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+
+            for (auto [off, sz] : seq_size) {
+                if (rd() % 2) {
+                    buf.push_substring(string_view(d).substr(off, sz), off, off + sz == offset);
+                } else {
+                    buf.push_substring(Buffer(d.substr(off, sz)), off, off + sz == offset);
+                }
+            }
+
+            auto result = read(buf);
+            if (buf.stream_out().bytes_written() != offset || !buf.stream_out().input_ended()) {
+                throw runtime_error("test 5 - number of bytes RX is incorrect");
+            }
+            if (!equal(result.cbegin(), result.cend(), d.cbegin())) {
+                throw runtime_error("test 5 - content of RX bytes is incorrect");
+            }
+        }
     } catch (const exception &e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
@@ -0,0 +1,147 @@
+#include "fsm_segments.hh"
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // the option survives serialization, and leaves room for three SACK blocks
+            TCPHeader header;
+            header.options.timestamp = TimestampOption{0xdeadbeef, 42};
+            for (uint32_t i = 0; i < 4; ++i) {
+                header.options.sack.push_back({WrappingInt32{1000 * i}, WrappingInt32{1000 * i + 500}});
+            }
+            TCPHeader parsed;
+            NetParser p{header.serialize()};
+            // a header with a timestamp should parse
+            test_should_be(parsed.parse(p) == ParseResult::NoError, true);
+            // the timestamp should round-trip
+            test_should_be(parsed.options.timestamp == header.options.timestamp, true);
+            // only three SACK blocks fit next to a timestamp
+            test_should_be(parsed.options.sack.size(), TCPOptions::MAX_SACK_BLOCKS_WITH_TIMESTAMP);
+        }
+
+        TCPConfig cfg;
+        cfg.timestamps = true;
+
+        {
+            // both ends offer timestamps: every segment carries one, echoing the peer's latest
+            TCPConnection client{cfg}, server{cfg};
+            client.connect();
+            client.tick(5);
+            const auto syn = pop(client);
+            // the SYN should offer timestamps
+            test_should_be((syn.header().options.timestamp == TimestampOption{0, 0}), true);
+            server.tick(100);
+            server.segment_received(syn);
+            const auto syn_ack = pop(server);
+            // the SYN-ACK should stamp its clock and echo the SYN
+            test_should_be((syn_ack.header().options.timestamp == TimestampOption{100, 0}), true);
+            client.segment_received(syn_ack);
+            // both ends offered timestamps
+            test_should_be(client.sender().timestamps_enabled(), true);
+            const auto ack = pop(client);
+            // the ACK should echo the SYN-ACK
+            test_should_be((ack.header().options.timestamp == TimestampOption{5, 100}), true);
+            server.segment_received(ack);
+
+            server.tick(10);
+            server.write("hello");
+            const auto data = pop(server);
+            // data should carry a timestamp
+            test_should_be((data.header().options.timestamp == TimestampOption{110, 5}), true);
+
+            // a segment stamped before the latest one is from an older pass through the sequence space
+            client.segment_received(data);
+            pop(client);
+            auto old = data;
+            old.header().seqno = data.header().seqno + 5;
+            old.header().options.timestamp = TimestampOption{109, 5};
+            old.payload() = string("stale");
+            client.segment_received(old);
+            // PAWS should drop the stale segment
+            test_should_be(client.inbound_stream().buffer_size(), 5u);
+            // a dropped segment should draw an ACK
+            test_should_be(pop(client).header().ackno, data.header().seqno + 5);
+            old.header().options.timestamp = TimestampOption{110, 5};
+            client.segment_received(old);
+            // a segment as recent as the last should be taken
+            test_should_be(client.inbound_stream().buffer_size(), 10u);
+            pop(client);
+
+            // a segment outside the window can't raise TS.Recent, which would make PAWS drop what follows
+            auto forged = data;
+            forged.header().seqno = data.header().seqno - 1000000;
+            forged.header().options.timestamp = TimestampOption{1000000000, 5};
+            client.segment_received(forged);
+            client.segments_out() = {};
+            auto next = data;
+            next.header().seqno = data.header().seqno + 10;
+            next.header().options.timestamp = TimestampOption{111, 5};
+            next.payload() = string("world");
+            client.segment_received(next);
+            // the next segment should be taken
+            test_should_be(client.inbound_stream().buffer_size(), 15u);
+        }
+
+        {
+            // a peer that doesn't offer timestamps doesn't get them
+            TCPConnection client{TCPConfig{}}, server{cfg};
+            client.connect();
+            server.segment_received(pop(client));
+            const auto syn_ack = pop(server);
+            // a SYN-ACK should only offer timestamps to a SYN that did
+            test_should_be(syn_ack.header().options.timestamp.has_value(), false);
+            test_should_be(server.sender().timestamps_enabled(), false);
+        }
+
+        {
+            // an echo times a retransmission, which Karn's algorithm would have to skip
+            TCPConfig sender_cfg = cfg;
+            sender_cfg.fixed_isn = WrappingInt32{0};
+            sender_cfg.adaptive_rto = true;
+            TCPSender sender{sender_cfg};
+            sender.fill_window();
+            TCPOptions peer;
+            peer.timestamp = TimestampOption{7, 0};
+            sender.peer_syn_options(peer);
+            sender.tick(20);
+            sender.timestamp_received(TimestampOption{7, 0});
+            sender.ack_received(WrappingInt32{1}, 60000);
+            // the SYN's echo should time the handshake
+            test_should_be(sender.srtt(), 20.0);
+            sender.stream_in().write("data");
+            sender.fill_window();
+            sender.segments_out() = {};
+            sender.tick(sender.next_timeout().value());
+            // the retransmission should carry a fresh timestamp
+            test_should_be(sender.segments_out().back().header().options.timestamp.value().value,
+                           sender.timestamp_clock());
+            const auto resent_at = sender.timestamp_clock();
+            sender.tick(20);
+            sender.timestamp_received(TimestampOption{8, resent_at});
+            sender.ack_received(WrappingInt32{5}, 60000);
+            // the echo of the retransmission should give a 20 ms sample
+            test_should_be(sender.srtt(), 20.0);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
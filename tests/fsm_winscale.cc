@@ -0,0 +1,81 @@
+#include "fsm_segments.hh"
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static TCPConfig config(const bool window_scaling) {
+    TCPConfig cfg;
+    cfg.recv_capacity = 4 * 1024 * 1024;
+    cfg.send_capacity = 4 * 1024 * 1024;
+    cfg.window_scaling = window_scaling;
+    return cfg;
+}
+
+int main() {
+    try {
+        {
+            // the window scale survives serialization, next to SACK-permitted
+            TCPHeader header;
+            header.syn = true;
+            header.options.sack_permitted = true;
+            header.options.window_scale = 7;
+            TCPHeader parsed;
+            NetParser p{header.serialize()};
+            // the header should parse
+            test_should_be(parsed.parse(p) == ParseResult::NoError, true);
+            // the options should round-trip
+            test_should_be(parsed.options.window_scale, 7);
+            test_should_be(parsed.options.sack_permitted, true);
+        }
+
+        for (const bool client_scales : {true, false}) {
+            for (const bool server_scales : {true, false}) {
+                TCPConnection client{config(client_scales)}, server{config(server_scales)};
+                client.connect();
+                const auto syn = pop(client);
+                // the SYN should offer the smallest shift that covers 4 MiB
+                test_should_be(syn.header().options.window_scale, client_scales ? optional<uint8_t>{7} : nullopt);
+                server.segment_received(syn);
+                const auto syn_ack = pop(server);
+                const bool scaling = client_scales and server_scales;
+                // the SYN/ACK should only offer a shift in answer to one
+                test_should_be(syn_ack.header().options.window_scale.has_value(), scaling);
+                // a SYN's window is never scaled, but capped
+                test_should_be(syn_ack.header().win, UINT16_MAX);
+                client.segment_received(syn_ack);
+                // both ends should agree on the shift
+                test_should_be(client.sender().send_window_shift(), (scaling ? 7 : 0));
+                test_should_be(server.sender().receive_window_shift(), (scaling ? 7 : 0));
+                const auto ack = pop(client);
+                // the ACK should advertise the scaled window
+                test_should_be(ack.header().win, scaling ? 4 * 1024 * 1024 >> 7 : UINT16_MAX);
+                server.segment_received(ack);
+
+                // the first data segment draws an ack with the scaled window, which opens up the rest
+                client.write(string(1024 * 1024, 'x'));
+                // the SYN/ACK's window should hold until the next ack
+                test_should_be(client.bytes_in_flight(), size_t{UINT16_MAX});
+                server.segment_received(pop(client));
+                client.segment_received(pop(server));
+                // only a scaled window should let more than 64 KiB into flight
+                test_should_be(client.bytes_in_flight() > UINT16_MAX, scaling);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
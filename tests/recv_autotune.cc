@@ -0,0 +1,196 @@
+#include "byte_stream.hh"
+#include "memory_budget.hh"
+#include "stream_reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+//! the stream byte at index `i`
+static char byte_at(const uint64_t i) { return static_cast<char>('a' + i % 23); }
+
+static string bytes_from(const uint64_t index, const size_t size) {
+    string data;
+    for (size_t i = 0; i < size; ++i) {
+        data.push_back(byte_at(index + i));
+    }
+    return data;
+}
+
+//! a peer that sends whatever the window allows once per `rtt`, to an application that reads
+//! up to `read_per_segment` bytes after each segment
+struct Transfer {
+    TCPReceiver receiver;
+    uint64_t sent{0};
+    uint64_t read{0};
+
+    explicit Transfer(const TCPConfig &cfg) : receiver(cfg) {
+        TCPSegment syn;
+        syn.header().syn = true;
+        receiver.segment_received(syn);
+    }
+
+    void round(const uint64_t rtt, const size_t read_per_segment) {
+        receiver.tick(rtt);
+        for (auto window = receiver.window_size(); window > 0;) {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{uint32_t(sent + 1)};
+            seg.payload() = bytes_from(sent, min<size_t>(window, 1000));
+            sent += seg.payload().size();
+            window -= seg.payload().size();
+            receiver.segment_received(seg);
+            const auto data = receiver.stream_out().read(read_per_segment);
+            // the stream should be intact
+            test_should_be(data, bytes_from(read, data.size()));
+            read += data.size();
+        }
+    }
+};
+
+int main() {
+    try {
+        for (const auto mode : {ByteStream::Mode::Ring, ByteStream::Mode::Mirrored, ByteStream::Mode::Chunked}) {
+            // growing keeps the unread bytes, even when they wrap around the ring
+            ByteStream stream{8, mode};
+            stream.write("abcdef");
+            stream.pop_output(5);
+            stream.write("ghijk");
+            stream.grow(20000);
+            // the stream should grow
+            test_should_be(stream.max_size(), 20000u);
+            test_should_be(stream.remaining_capacity(), 20000u - 6);
+            stream.write(string(10000, 'x'));
+            // the bytes should survive
+            test_should_be(stream.read(6), "fghijk"s);
+            test_should_be(stream.read(20000), string(10000, 'x'));
+        }
+
+        {
+            // the footprint is of the storage as allocated: a whole ring, never less than it has
+            test_should_be(ByteStream(16000).footprint(16000), 16384u);
+            test_should_be(ByteStream(16000).footprint(100), 16384u);
+            test_should_be(ByteStream(16000).footprint(16385), 32768u);
+            test_should_be(ByteStream(16000, ByteStream::Mode::Mirrored).footprint(16000),
+                           MirroredMemory::size_for(16000));
+            test_should_be(ByteStream(16000, ByteStream::Mode::Chunked).footprint(16000), 16000u);
+            // the slab's arena is rounded up too, and comes on top of the output's ring
+            test_should_be(StreamReassembler(16000, StreamReassembler::Backend::Slab).footprint(20000), 65536u);
+            test_should_be(StreamReassembler(16000).footprint(16000), 16384u);
+        }
+
+        for (const auto backend :
+             {StreamReassembler::Backend::Queue, StreamReassembler::Backend::Ring, StreamReassembler::Backend::Slab}) {
+            // growing keeps the bytes stored out of order, and widens the window
+            StreamReassembler reassembler{8, backend};
+            reassembler.push_substring(bytes_from(0, 6), 0, false);
+            reassembler.stream_out().pop_output(5);
+            reassembler.push_substring(bytes_from(9, 4), 9, false);
+            reassembler.grow(4096);
+            reassembler.push_substring(bytes_from(13, 3000), 13, false);
+            // the stored bytes should be kept
+            test_should_be(reassembler.unassembled_bytes(), 3004u);
+            reassembler.push_substring(bytes_from(6, 3), 6, false);
+            // the stream should be intact
+            test_should_be(reassembler.stream_out().read(4096), bytes_from(5, 3008));
+        }
+
+        TCPConfig cfg;
+        cfg.recv_capacity = 16000;
+        cfg.recv_autotune = true;
+        cfg.recv_capacity_max = 1024 * 1024;
+
+        {
+            // an application that keeps up lets the buffer grow, until the limit
+            Transfer fast{cfg};
+            for (size_t i = 0; i < 20; ++i) {
+                fast.round(10, SIZE_MAX);
+            }
+            // the receiver should measure the RTT
+            test_should_be(fast.receiver.rtt_estimate(), 10u);
+            // the buffer should grow to the limit
+            test_should_be(fast.receiver.buffer_capacity(), cfg.recv_capacity_max);
+
+            // one that reads slowly keeps the buffer it started with
+            Transfer slow{cfg};
+            for (size_t i = 0; i < 20; ++i) {
+                slow.round(10, 100);
+            }
+            // a slow reader shouldn't grow the buffer
+            test_should_be(slow.receiver.buffer_capacity(), cfg.recv_capacity);
+
+            // without autotuning, the buffer stays put
+            TCPConfig fixed = cfg;
+            fixed.recv_autotune = false;
+            Transfer still{fixed};
+            for (size_t i = 0; i < 20; ++i) {
+                still.round(10, SIZE_MAX);
+            }
+            // the buffer should stay put
+            test_should_be(still.receiver.buffer_capacity(), cfg.recv_capacity);
+        }
+
+        {
+            // connections that share a budget grow only as far as it goes, and give it back when they're done
+            auto budget = make_shared<MemoryBudget>(2 * 16384 + 200000);
+            TCPConfig shared = cfg;
+            shared.recv_budget = budget;
+            {
+                Transfer a{shared}, b{shared};
+                // the initial buffers should be charged as the rings they take
+                test_should_be(budget->used(), 2 * 16384u);
+                for (size_t i = 0; i < 20; ++i) {
+                    a.round(10, SIZE_MAX);
+                    b.round(10, SIZE_MAX);
+                }
+                // the budget should bound the buffers
+                test_should_be(a.receiver.buffer_capacity() < cfg.recv_capacity_max, true);
+                test_should_be(b.receiver.buffer_capacity() < cfg.recv_capacity_max, true);
+                test_should_be(budget->used() <= budget->limit(), true);
+                // the rings should be charged, not the capacities
+                test_should_be(budget->used(),
+                               StreamReassembler(a.receiver.buffer_capacity()).footprint(0) +
+                                   StreamReassembler(b.receiver.buffer_capacity()).footprint(0));
+            }
+            // the budget should be given back
+            test_should_be(budget->used(), 0u);
+        }
+
+        {
+            // growing holds the old ring and the new one at once, so the budget must fit both
+            TCPConfig tight = cfg;
+            tight.recv_budget = make_shared<MemoryBudget>(16384 + 32767);
+            Transfer stuck{tight};
+            for (size_t i = 0; i < 20; ++i) {
+                stuck.round(10, SIZE_MAX);
+            }
+            // the buffer should grow only within the ring it has
+            test_should_be(stuck.receiver.buffer_capacity(), 16384u);
+            test_should_be(tight.recv_budget->used(), 16384u);
+
+            tight.recv_budget = make_shared<MemoryBudget>(16384 + 32768);
+            Transfer grown{tight};
+            for (size_t i = 0; i < 20; ++i) {
+                grown.round(10, SIZE_MAX);
+            }
+            // the buffer should grow into the bigger ring, and the old one should be given back
+            test_should_be(grown.receiver.buffer_capacity() > 16384u, true);
+            test_should_be(grown.receiver.buffer_capacity() <= 32768u, true);
+            test_should_be(tight.recv_budget->used(), 32768u);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+#include "congestion_control.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static bool near(const double value, const double expected) { return abs(value - expected) < 0.01; }
+
+int main() {
+    try {
+        {
+            // a 100 bytes/ms path with a 50 ms round trip: the BDP is 5000 bytes
+            Bbr bbr{1000};
+            uint64_t now = 0, delivered = 0;
+            const auto round = [&](const size_t in_flight, const uint64_t rtt = 50) {
+                now += rtt;
+                delivered += 100 * rtt;
+                bbr.on_rate_sample({delivered, delivered - 100 * rtt, rtt, 100 * rtt, in_flight, rtt}, now);
+            };
+
+            round(20000);
+            // BBR should start in STARTUP
+            test_should_be(bbr.mode() == Bbr::Mode::Startup, true);
+            // BBR should model the path
+            test_should_be(near(bbr.bottleneck_bandwidth(), 100), true);
+            test_should_be(bbr.min_rtt(), 50u);
+            // STARTUP should pace at 2/ln 2 times the bandwidth
+            test_should_be(near(*bbr.pacing_rate(), 288.5), true);
+
+            // three rounds without growth fill the pipe
+            round(20000);
+            round(20000);
+            // two rounds without growth shouldn't end STARTUP
+            test_should_be(bbr.mode() == Bbr::Mode::Startup, true);
+            round(20000);
+            // BBR should drain once the bandwidth stops growing
+            test_should_be(bbr.mode() == Bbr::Mode::Drain, true);
+            // DRAIN should pace below the bandwidth
+            test_should_be(near(*bbr.pacing_rate(), 100 / 2.885), true);
+
+            round(5000);
+            // BBR should probe for bandwidth once the queue is gone
+            test_should_be(bbr.mode() == Bbr::Mode::ProbeBw, true);
+            // PROBE_BW should cruise at the bandwidth
+            test_should_be(near(*bbr.pacing_rate(), 100), true);
+            for (unsigned i = 0; i < 20; ++i) {
+                round(5000);
+            }
+            // the window should settle at twice the BDP, plus three segments
+            test_should_be(bbr.cwnd(), 2u * 5000 + 3 * 1000);
+
+            // a loss doesn't shrink the window, but a timeout does
+            bbr.on_loss(5000, now);
+            // BBR shouldn't react to a single loss
+            test_should_be(bbr.cwnd(), 13000u);
+            bbr.on_rto(5000, now);
+            // a timeout should collapse the window
+            test_should_be(bbr.cwnd(), 1000u);
+            round(5000);
+            // the window should return to at least four segments
+            test_should_be(bbr.cwnd() >= 4000, true);
+        }
+
+        {
+            Bbr bbr{1000};
+            uint64_t now = 0, delivered = 0;
+            const auto round = [&](const size_t in_flight, const uint64_t rtt) {
+                now += rtt;
+                delivered += 100 * rtt;
+                bbr.on_rate_sample({delivered, delivered - 100 * rtt, rtt, 100 * rtt, in_flight, rtt}, now);
+            };
+            for (unsigned i = 0; i < 4; ++i) {
+                round(20000, 50);
+            }
+            round(5000, 50);
+            // BBR should reach PROBE_BW
+            test_should_be(bbr.mode() == Bbr::Mode::ProbeBw, true);
+
+            // a standing queue hides the propagation delay for ten seconds...
+            while (now < 10300) {
+                round(13000, 60);
+            }
+            // BBR should probe the RTT once the minimum expires
+            test_should_be(bbr.mode() == Bbr::Mode::ProbeRtt, true);
+            // PROBE_RTT should hold four segments in flight
+            test_should_be(bbr.cwnd(), 4000u);
+            // ...until PROBE_RTT drains it
+            round(4000, 50);
+            // PROBE_RTT should find the propagation delay again
+            test_should_be(bbr.min_rtt(), 50u);
+            for (unsigned i = 0; i < 4; ++i) {
+                round(4000, 50);
+            }
+            // BBR should return to PROBE_BW after 200 ms
+            test_should_be(bbr.mode() == Bbr::Mode::ProbeBw, true);
+            // BBR should restore the window it had before PROBE_RTT
+            test_should_be(bbr.cwnd() >= 13000, true);
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.congestion_control = CongestionAlgorithm::Bbr;
+
+            // BBR paces even though cfg.pacing is off
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.tick(100);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(8000, 'x'));
+            sender.fill_window();
+            // without a model yet, the initial window should go out at once
+            test_should_be(sender.bytes_in_flight(), 4000u);
+            sender.tick(50);
+            sender.ack_received(WrappingInt32{1001}, 60000);
+            const auto bbr = dynamic_cast<const Bbr *>(sender.congestion_control());
+            // the first ACK should measure 1000 bytes in 50 ms
+            test_should_be(bbr != nullptr, true);
+            test_should_be(near(bbr->bottleneck_bandwidth(), 20), true);
+            test_should_be(bbr->min_rtt(), 50u);
+            // the sender should pace at 2.885 * 20 bytes per ms
+            test_should_be(sender.next_send_time(), 18u);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+#include "congestion_control.hh"
+#include "sender_harness.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionAlgorithm::NewReno;
+
+            TCPSenderTestHarness test{"NewReno slow start and timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(20000, 'a')});
+            // the initial window is 4 segments, however large the receiver's window
+            for (unsigned i = 0; i < 4; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{4000});
+
+            // each acknowledged segment grows the window by one segment
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 1000}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 4000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 5000));
+            test.execute(ExpectNoSegment{});
+
+            // a timeout collapses the window to one segment, and only the oldest segment is resent
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000));
+            test.execute(ExpectNoSegment{});
+
+            // once everything is acknowledged, slow start resumes from one segment
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 6000}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 6000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 7000));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionAlgorithm::Cubic;
+
+            TCPSenderTestHarness test{"The receiver's window still applies", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1500));
+            test.execute(WriteBytes{string(20000, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(500).with_seqno(isn + 1 + 1000));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            NewReno reno{1000};
+            reno.on_loss(20000, 0);
+            // NewReno should halve the flight on a loss
+            test_should_be(reno.cwnd(), 10000u);
+            test_should_be(reno.ssthresh(), 10000u);
+            for (unsigned i = 0; i < 10; ++i) {
+                reno.on_ack(1000, 10000, 0);
+            }
+            // NewReno should add one segment per window in congestion avoidance
+            test_should_be(reno.cwnd(), 11000u);
+            reno.on_rto(11000, 0);
+            // NewReno should restart from one segment
+            test_should_be(reno.cwnd(), 1000u);
+            test_should_be(reno.ssthresh(), 5500u);
+        }
+
+        {
+            Cubic cubic{1000};
+            // leave slow start at 100 segments
+            for (unsigned i = 0; i < 96; ++i) {
+                cubic.on_ack(1000, 0, 0);
+            }
+            cubic.on_loss(100000, 0);
+            // CUBIC should cut the window to 70%
+            test_should_be(cubic.cwnd(), 70000u);
+            test_should_be(cubic.ssthresh(), 70000u);
+
+            // K = cbrt(100 * 0.3 / 0.4) ~ 4.2 s: the window climbs back towards, but stays under, 100 segments...
+            uint64_t now = 0;
+            for (; now < 4000; now += 10) {
+                cubic.on_ack(1000, 0, now);
+            }
+            // CUBIC should approach the last maximum
+            test_should_be(cubic.cwnd() > 90000, true);
+            test_should_be(cubic.cwnd() < 100000, true);
+            const auto plateau = cubic.cwnd();
+            for (; now < 4400; now += 10) {
+                cubic.on_ack(1000, 0, now);
+            }
+            // CUBIC should plateau around the last maximum
+            test_should_be(cubic.cwnd() - plateau < 2000, true);
+            // ...and then probes beyond it
+            for (; now < 8000; now += 10) {
+                cubic.on_ack(1000, 0, now);
+            }
+            // CUBIC should probe beyond the last maximum
+            test_should_be(cubic.cwnd() > 110000, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+#include "sender_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Three duplicate ACKs resend the lost segment", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(5000, 'a')});
+            for (unsigned i = 0; i < 5; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            // the second segment is lost
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectNoSegment{});
+
+            // the fourth was lost too: the partial ack resends it right away
+            test.execute(AckReceived{WrappingInt32{isn + 3001}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 3001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 5001}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Window updates aren't duplicate ACKs", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{string(3000, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(2000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(4000));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without fast retransmit, duplicate ACKs wait for the timer", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(5000, 'a')});
+            for (unsigned i = 0; i < 5; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            for (unsigned i = 0; i < 4; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.fast_retransmit = true;
+            cfg.congestion_control = CongestionAlgorithm::NewReno;
+
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(20000, 'a'));
+            sender.fill_window();
+            // slow start from 4 segments: each ack releases two more
+            for (uint32_t ack = 1001; ack <= 4001; ack += 1000) {
+                sender.ack_received(WrappingInt32{ack}, 60000);
+            }
+            // slow start should have 8 segments in flight
+            test_should_be(sender.bytes_in_flight(), 8000u);
+
+            // the segment at 4001 is lost, and the 7 after it are duplicate-acked
+            for (unsigned i = 0; i < 3; ++i) {
+                sender.ack_received(WrappingInt32{4001}, 60000);
+            }
+            // fast retransmit
+            test_should_be(sender.fast_retransmissions(), 1u);
+            test_should_be(sender.duplicate_acks(), 3u);
+            // the window should be halved
+            test_should_be(sender.congestion_control()->cwnd(), 4000u);
+            while (not sender.segments_out().empty()) {
+                sender.segments_out().pop();
+            }
+            // the inflated window reaches the 8 segments in flight at the 4th duplicate,
+            // and each duplicate after that lets a new segment out
+            for (unsigned i = 0; i < 4; ++i) {
+                sender.ack_received(WrappingInt32{4001}, 60000);
+            }
+            // inflation should let new data out
+            test_should_be(sender.segments_out().size(), 3u);
+            sender.ack_received(WrappingInt32{12001}, 60000);
+            // a full ack should end recovery at ssthresh
+            test_should_be(sender.congestion_control()->cwnd(), 4000u);
+            test_should_be(sender.duplicate_acks(), 7u);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include "congestion_control.hh"
+#include "sender_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionAlgorithm::NewReno;
+            cfg.adaptive_rto = true;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"Pacing spreads the initial window over the round trip", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            // SRTT = 100 ms and cwnd = 4000 bytes, so in slow start the pacer lets out 80 bytes per ms
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(4000, 'x')});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{12});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            // the bucket holds no more than two segments, however long the sender waits
+            test.execute(Tick{100});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionAlgorithm::NewReno;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"Without pacing, the initial window goes out at once", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(4000, 'x')});
+            for (uint32_t i = 0; i < 4; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.congestion_control = CongestionAlgorithm::NewReno;
+            cfg.adaptive_rto = true;
+            cfg.pacing = true;
+
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.tick(100);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            // nothing should wait on the pacer yet
+            test_should_be(sender.next_send_time().has_value(), false);
+            sender.stream_in().write(string(4000, 'x'));
+            sender.fill_window();
+            // 1000 bytes at 80 bytes per ms should take 13 ms
+            test_should_be(sender.next_send_time(), 13u);
+            sender.tick(5);
+            // the wait should shrink as time passes
+            test_should_be(sender.next_send_time(), 8u);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
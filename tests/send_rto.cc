@@ -0,0 +1,128 @@
+#include "sender_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 1;
+
+            TCPSenderTestHarness test{"The RTO follows the measured round trip", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            // SRTT = 10, RTTVAR = 5, so RTO = 10 + 4 * 5
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick{29});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+
+            // the ack of a retransmitted segment is ambiguous and leaves the estimate alone (Karn's algorithm)
+            test.execute(Tick{5});
+            test.execute(AckReceived{WrappingInt32{isn + 4}});
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def").with_seqno(isn + 4));
+            test.execute(Tick{29});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("def").with_seqno(isn + 4));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"The RTO stays above its lower bound", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{1});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick{TCPConfig::RTO_MIN_DFLT - 1});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 1;
+            cfg.rto_max = 100;
+
+            TCPSenderTestHarness test{"Backoff stops at the upper bound", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            for (const uint64_t timeout : {30, 60, 100, 100}) {
+                test.execute(Tick{timeout - 1});
+                test.execute(ExpectNoSegment{});
+                test.execute(Tick{1});
+                test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 1;
+
+            TCPSender sender{cfg};
+            // the RTO should start from rt_timeout
+            test_should_be(sender.srtt().has_value(), false);
+            test_should_be(sender.rto(), cfg.rt_timeout);
+            sender.fill_window();
+            sender.tick(10);
+            sender.ack_received(WrappingInt32{1}, 1000);
+            // first RTT sample
+            test_should_be(sender.srtt(), 10.0);
+            test_should_be(sender.rttvar(), 5.0);
+            test_should_be(sender.rto(), 30u);
+
+            sender.stream_in().write("abc");
+            sender.fill_window();
+            sender.tick(20);
+            sender.ack_received(WrappingInt32{4}, 1000);
+            // RTTVAR = 3/4 * 5 + 1/4 * |10 - 20|, SRTT = 7/8 * 10 + 1/8 * 20
+            // second RTT sample
+            test_should_be(sender.srtt(), 11.25);
+            test_should_be(sender.rttvar(), 6.25);
+            test_should_be(sender.rto(), 37u);
+
+            TCPSender fixed{TCPConfig{}};
+            // a fixed RTO should not report an estimate
+            test_should_be(fixed.srtt().has_value(), false);
+            test_should_be(fixed.rttvar().has_value(), false);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
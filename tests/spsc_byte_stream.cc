@@ -0,0 +1,109 @@
+#include "spsc_byte_stream.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+static bool signalled(FileDescriptor &fd) {
+    pollfd pfd{fd.fd_num(), POLLIN, 0};
+    return SystemCall("poll", ::poll(&pfd, 1, 0)) == 1;
+}
+
+static char pattern(const uint64_t index) { return static_cast<char>((index * 2654435761ULL) >> 13); }
+
+// Moves `total` bytes from a writer thread to the main thread through a stream of `capacity` bytes,
+// with random write and read sizes, and checks that every byte arrives in order.
+static void transfer(const size_t capacity, const size_t total, const size_t max_chunk) {
+    SpscByteStream stream{capacity};
+
+    thread writer([&] {
+        auto rd = get_random_generator();
+        size_t sent = 0;
+        string chunk;
+        while (sent < total) {
+            chunk.resize(min(total - sent, 1 + rd() % max_chunk));
+            for (size_t i = 0; i < chunk.size(); i++) {
+                chunk[i] = pattern(sent + i);
+            }
+            string_view remaining{chunk};
+            while (not remaining.empty()) {
+                stream.wait_writable();
+                const auto written = stream.write(remaining);
+                remaining.remove_prefix(written);
+                sent += written;
+            }
+        }
+        stream.end_input();
+    });
+
+    auto rd = get_random_generator();
+    size_t received = 0;
+    while (not stream.eof()) {
+        stream.wait_readable();
+        const auto data = stream.read(1 + rd() % max_chunk);
+        for (size_t i = 0; i < data.size(); i++) {
+            if (data[i] != pattern(received + i)) {
+                writer.join();
+                throw runtime_error("byte " + to_string(received + i) + " was corrupted");
+            }
+        }
+        received += data.size();
+    }
+    writer.join();
+
+    if (received != total or stream.bytes_written() != total or stream.bytes_read() != total) {
+        throw runtime_error("received " + to_string(received) + " bytes, expected " + to_string(total));
+    }
+}
+
+int main() {
+    try {
+        transfer(1, 10000, 4);
+        transfer(4096, 16 * 1024 * 1024, 3000);
+        transfer(65536, 64 * 1024 * 1024, 65536);
+
+        {
+            // only a side that has parked is signalled
+            SpscByteStream stream{8};
+            stream.write("abc");
+            stream.read(3);
+            if (signalled(stream.readable_fd())) {
+                throw runtime_error("a write shouldn't signal a reader that isn't parked");
+            }
+            if (not stream.park_reader() or stream.write("d") != 1 or not signalled(stream.readable_fd())) {
+                throw runtime_error("a write should signal a parked reader");
+            }
+            if (stream.park_reader()) {
+                throw runtime_error("the reader shouldn't park on a stream with bytes");
+            }
+        }
+
+        {
+            SpscByteStream stream{8};
+            if (stream.write("abcdefghij") != 8 or stream.remaining_capacity() != 0) {
+                throw runtime_error("write should have been truncated to the capacity");
+            }
+            if (stream.read(3) != "abc" or stream.write("xyz") != 3 or stream.peek_output(8) != "defghxyz") {
+                throw runtime_error("stream did not wrap around correctly");
+            }
+            stream.set_error();
+            stream.wait_readable();
+            stream.wait_writable();
+            if (not stream.error()) {
+                throw runtime_error("error flag was lost");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,265 @@
+#include "address.hh"
+#include "connection_table.hh"
+#include "four_tuple.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "tcp_stack.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//! carry the segments each stack sent to the other, until neither has more to say
+static void exchange(TCPStack &a, TCPStack &b) {
+    while (not a.segments_out().empty() or not b.segments_out().empty()) {
+        for (auto [from, to] : {pair{&a, &b}, pair{&b, &a}}) {
+            auto out = move(from->segments_out());
+            from->segments_out() = {};
+            while (not out.empty()) {
+                const auto &[tuple, seg] = out.front();
+                to->segment_received({tuple.remote_address, tuple.local_address, tuple.remote_port, tuple.local_port},
+                                     seg);
+                out.pop();
+            }
+        }
+    }
+}
+
+int main() {
+    try {
+        {
+            // the table agrees with a map through growth and many erasures
+            ConnectionTable table;
+            unordered_map<uint64_t, uint32_t> reference;
+            mt19937 rng{1};
+            auto tuple_of = [](const uint64_t key) {
+                return FourTuple{0x0a000001, 0x0a000000 | uint32_t(key >> 16), 80, uint16_t(key)};
+            };
+            for (uint32_t i = 0; i < 200000; ++i) {
+                const uint64_t key = rng() % 5000;
+                if (rng() % 3 == 0) {
+                    // erase() agrees with the map
+                    test_should_be(table.erase(tuple_of(key)), reference.erase(key) == 1);
+                } else {
+                    table.insert(tuple_of(key), i);
+                    reference[key] = i;
+                }
+            }
+            // the sizes should agree
+            test_should_be(table.size(), reference.size());
+            // the table should be at most three quarters full
+            test_should_be(table.slots() * 3 / 4 >= table.size(), true);
+            for (uint64_t key = 0; key < 5000; ++key) {
+                const auto found = table.find(tuple_of(key));
+                const auto expected = reference.find(key);
+                // find() agrees with the map
+                test_should_be(found, expected == reference.end() ? optional<uint32_t>{} : expected->second);
+            }
+        }
+
+        TCPConfig cfg;
+        cfg.rt_timeout = 100;
+        const Address server_address{"10.0.0.1", 80}, client_address{"10.0.0.2", 0};
+
+        {
+            // a listener keeps as many established connections as its backlog allows
+            TCPStack server{cfg}, client{cfg};
+            server.listen(80, {2});
+            const auto first = client.connect(client_address, server_address);
+            client.connect(client_address, server_address);
+            // ports should be picked in order
+            test_should_be(client.tuple(first).local_port, TCPStack::EPHEMERAL_PORTS_BEGIN);
+            exchange(client, server);
+            const auto third = client.connect(client_address, server_address);
+            exchange(client, server);
+            // the SYN beyond the backlog should be dropped
+            test_should_be(server.size(), 2u);
+            // two connections should wait
+            test_should_be(server.accept(80).has_value(), true);
+            test_should_be(server.accept(80).has_value(), true);
+            // the third shouldn't have been opened
+            test_should_be(server.accept(80).has_value(), false);
+
+            client.tick(cfg.rt_timeout);
+            exchange(client, server);
+            const auto accepted = server.accept(80);
+            // the retransmitted SYN should get through
+            test_should_be(accepted.has_value(), true);
+            // accept() should hand it over
+            test_should_be(server.tuple(*accepted).remote_port, client.tuple(third).local_port);
+        }
+
+        {
+            // data flows both ways, and closed connections are forgotten once they're done
+            TCPStack server{cfg}, client{cfg};
+            server.listen(80);
+            const auto conn = client.connect(client_address, server_address);
+            exchange(client, server);
+            const auto peer = server.accept(80).value();
+            client.write(conn, "hello");
+            exchange(client, server);
+            // the server should read what the client wrote
+            test_should_be(server.inbound_stream(peer).read(5), "hello"s);
+            server.write(peer, "world");
+            exchange(client, server);
+            // the client should read what the server wrote
+            test_should_be(client.inbound_stream(conn).read(5), "world"s);
+
+            client.close(conn);
+            exchange(client, server);
+            // the server should see the end of the stream
+            test_should_be(server.inbound_stream(peer).eof(), true);
+            server.close(peer);
+            exchange(client, server);
+            // the client should linger in TIME_WAIT
+            test_should_be(server.size(), 0u);
+            test_should_be(client.size(), 1u);
+            client.tick(10 * cfg.rt_timeout);
+            // TIME_WAIT should end
+            test_should_be(client.size(), 0u);
+            // the id should be reused
+            test_should_be(client.connect(client_address, server_address), conn);
+        }
+
+        {
+            // a segment for a port nobody listens on draws a RST
+            TCPStack server{cfg}, client{cfg};
+            const auto conn = client.connect(client_address, Address{"10.0.0.1", 81});
+            exchange(client, server);
+            // the client should be reset
+            test_should_be(client.connection(conn).active(), false);
+            // a reset connection should leave the table
+            test_should_be(client.size(), 0u);
+        }
+
+        {
+            // many connections share the stacks, each with its own data
+            constexpr size_t N = 2000;
+            TCPStack server{cfg}, client{cfg};
+            server.listen(80, {N});
+            vector<TCPStack::ConnectionId> conns;
+            for (size_t i = 0; i < N; ++i) {
+                conns.push_back(client.connect(client_address, server_address));
+            }
+            exchange(client, server);
+            for (size_t i = 0; i < N; ++i) {
+                client.write(conns[i], to_string(i));
+            }
+            exchange(client, server);
+            // every connection should be open
+            test_should_be(server.size(), N);
+            for (size_t i = 0; i < N; ++i) {
+                const auto peer = server.accept(80).value();
+                const auto port = server.tuple(peer).remote_port;
+                const auto data = server.inbound_stream(peer).read(10);
+                // each connection should carry its own data
+                test_should_be(data, to_string(port - TCPStack::EPHEMERAL_PORTS_BEGIN));
+            }
+        }
+
+        {
+            // a SYN flood fills the half-open backlog, and no more
+            TCPStack server{cfg};
+            server.listen(80, {128, 16, ListenConfig::SynCookies::Never});
+            TCPSegment syn;
+            syn.header().syn = true;
+            for (uint16_t port = 1; port <= 10000; ++port) {
+                server.segment_received({0x0a000001, uint32_t{0x0b000000} | port, 80, port}, syn);
+            }
+            // only 16 SYNs should be answered
+            test_should_be(server.size(), 16u);
+            test_should_be(server.segments_out().size(), 16u);
+        }
+
+        {
+            // beyond the half-open backlog, SYNs are answered with cookies, and cost nothing until they're ACKed
+            TCPStack server{cfg}, client{cfg};
+            server.listen(80, {128, 16, ListenConfig::SynCookies::WhenFull});
+            TCPSegment syn;
+            syn.header().syn = true;
+            for (uint16_t port = 1; port <= 10000; ++port) {
+                server.segment_received({0x0a000001, uint32_t{0x0b000000} | port, 80, port}, syn);
+            }
+            // every SYN should be answered
+            test_should_be(server.size(), 16u);
+            test_should_be(server.segments_out().size(), 10000u);
+            server.segments_out() = {};
+
+            const auto conn = client.connect(client_address, server_address);
+            exchange(client, server);
+            // the ACK of the cookie should open the connection
+            test_should_be(server.size(), 17u);
+            const auto peer = server.accept(80).value();
+            // accept() should hand it over
+            test_should_be(server.tuple(peer).remote_port, client.tuple(conn).local_port);
+            client.write(conn, "hello");
+            server.write(peer, "world");
+            exchange(client, server);
+            // data should flow both ways
+            test_should_be(server.inbound_stream(peer).read(5), "hello"s);
+            test_should_be(client.inbound_stream(conn).read(5), "world"s);
+        }
+
+        {
+            // a cookie remembers the peer's MSS, rounded down, and only for two periods
+            TCPConfig client_cfg = cfg, server_cfg = cfg;
+            client_cfg.mss = 1400;
+            server_cfg.mss = 1460;
+            server_cfg.adaptive_rto = true;
+            TCPStack server{server_cfg}, client{client_cfg};
+            server.listen(80, {128, 16, ListenConfig::SynCookies::Always});
+            client.connect(client_address, server_address);
+            exchange(client, server);
+            const auto peer = server.accept(80).value();
+            // the MSS should be rounded down
+            test_should_be(server.connection(peer).sender().max_segment_size(), 1380u);
+            // the connection should be open
+            test_should_be(server.size(), 1u);
+            // the SYN-ACK the cookie stands for wasn't sent just now, so its ACK shouldn't time a round trip
+            test_should_be(server.connection(peer).sender().srtt().has_value(), false);
+
+            client.connect(client_address, server_address);
+            const auto [tuple, syn] = client.segments_out().front();
+            const FourTuple server_tuple{
+                tuple.remote_address, tuple.local_address, tuple.remote_port, tuple.local_port};
+            server.segment_received(server_tuple, syn);
+            // a cookie should keep nothing
+            test_should_be(server.size(), 1u);
+            const auto syn_ack = server.segments_out().back().second;
+            server.tick(2 * TCPStack::SYN_COOKIE_PERIOD_MS);
+            TCPSegment stale;
+            stale.header().ack = true;
+            stale.header().seqno = syn.header().seqno + 1;
+            stale.header().ackno = syn_ack.header().seqno + 1;
+            server.segment_received(server_tuple, stale);
+            // a stale cookie should draw a RST
+            test_should_be(server.size(), 1u);
+            test_should_be(server.segments_out().back().second.header().rst, true);
+
+            const FourTuple forged{0x0a000001, 0x0a000002, 80, 1234};
+            TCPSegment ack;
+            ack.header().ack = true;
+            ack.header().seqno = WrappingInt32{1000};
+            ack.header().ackno = WrappingInt32{0x12345678};
+            server.segment_received(forged, ack);
+            // a forged cookie should draw a RST
+            test_should_be(server.size(), 1u);
+            test_should_be(server.segments_out().back().second.header().rst, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -7,20 +7,31 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 #define test_should_be(act, exp) _test_should_be(act, exp, #act, #exp, __LINE__)
 
-template <typename T>
+//! whether `expected - actual` means something, to report it
+template <typename T, typename U, typename = void>
+struct _has_difference : std::false_type {};
+template <typename T, typename U>
+struct _has_difference<T, U, std::void_t<decltype(std::declval<U>() - std::declval<T>())>> : std::true_type {};
+
+template <typename T, typename U>
 static void _test_should_be(const T &actual,
-                            const T &expected,
+                            const U &expected,
                             const char *actual_s,
                             const char *expected_s,
                             const int lineno) {
     if (actual != expected) {
         std::ostringstream ss;
         ss << "`" << actual_s << "` should have been `" << expected_s << "`, but the former is\n\t" << to_string(actual)
-           << "\nand the latter is\n\t" << to_string(expected) << " (difference of " << expected - actual << ")\n"
-           << " (at line " << lineno << ")\n";
+           << "\nand the latter is\n\t" << to_string(expected);
+        if constexpr (_has_difference<T, U>::value) {
+            ss << " (difference of " << expected - actual << ")";
+        }
+        ss << "\n (at line " << lineno << ")\n";
         throw std::runtime_error(ss.str());
     }
 }
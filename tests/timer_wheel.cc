@@ -0,0 +1,135 @@
+#include "arp_message.hh"
+#include "network_interface.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+#include "timer_wheel.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! the segments a connection sends, and when
+static void collect(TCPConnection &conn, const uint64_t now, vector<pair<uint64_t, uint64_t>> &sent) {
+    while (not conn.segments_out().empty()) {
+        sent.emplace_back(now, conn.segments_out().front().header().seqno.raw_value());
+        conn.segments_out().pop();
+    }
+}
+
+int main() {
+    try {
+        {
+            // timers fire at their deadlines, in every wheel, and cancelled ones don't
+            TimerWheel wheel;
+            mt19937 rng{1};
+            vector<pair<uint64_t, size_t>> fired;
+            vector<uint64_t> deadlines;
+            vector<TimerWheel::Id> ids;
+            for (size_t i = 0; i < 2000; ++i) {
+                const uint64_t delay = i < 10 ? (uint64_t{1} << 24) + i * 977 : rng() % (uint64_t{1} << (4 + i % 20));
+                deadlines.push_back(max<uint64_t>(delay, 1));
+                ids.push_back(wheel.schedule(delay, [&fired, &wheel, i] { fired.emplace_back(wheel.now(), i); }));
+            }
+            for (size_t i = 0; i < ids.size(); i += 7) {
+                wheel.cancel(ids[i]);
+            }
+            // cancelled timers shouldn't count
+            test_should_be(wheel.size(), 2000u - 286);
+            wheel.advance(1000);
+            wheel.advance(uint64_t{1} << 25);
+            // every timer should have fired
+            test_should_be(wheel.size(), 0u);
+            // every timer but the cancelled should fire once
+            test_should_be(fired.size(), 2000u - 286);
+            uint64_t last = 0;
+            for (const auto &[when, i] : fired) {
+                // a cancelled timer shouldn't fire
+                test_should_be(i % 7 != 0, true);
+                // each timer should fire at its deadline
+                test_should_be(when, deadlines[i]);
+                // timers should fire in order
+                test_should_be(when >= last, true);
+                last = when;
+            }
+        }
+
+        {
+            // a connection ticked only when its timers are due sends what one ticked every millisecond does
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.rt_timeout = 10;
+            TCPConnection every_ms{cfg}, on_timer{cfg};
+            TimerWheel wheel;
+            WheelTicker<TCPConnection> ticker{wheel, on_timer};
+            vector<pair<uint64_t, uint64_t>> expected, actual;
+
+            every_ms.connect();
+            on_timer.connect();
+            ticker.rearm();
+            for (uint64_t now = 1; now <= 60000; ++now) {
+                collect(every_ms, now, expected);
+                if (every_ms.active()) {
+                    every_ms.tick(1);
+                }
+                collect(on_timer, now, actual);
+                wheel.advance(1);
+            }
+            // the SYN should be resent until the RST
+            test_should_be(expected.size(), 1 + TCPConfig::MAX_RETX_ATTEMPTS + 1);
+            // the wheel should tick the connection when its timers are due
+            test_should_be(actual == expected, true);
+            // a reset connection shouldn't keep a timer
+            test_should_be(on_timer.active(), false);
+            test_should_be(wheel.size(), 0u);
+        }
+
+        {
+            // an interface needs ticking only to forget what it learned
+            NetworkInterface iface{{2, 0, 0, 0, 0, 1}, Address("10.0.0.1", 0)};
+            // an interface that learned nothing needs no ticks
+            test_should_be(iface.next_timer().has_value(), false);
+            ARPMessage arp;
+            arp.opcode = ARPMessage::OPCODE_REPLY;
+            arp.sender_ethernet_address = {2, 0, 0, 0, 0, 2};
+            arp.sender_ip_address = Address("10.0.0.2", 0).ipv4_numeric();
+            arp.target_ethernet_address = {2, 0, 0, 0, 0, 1};
+            arp.target_ip_address = Address("10.0.0.1", 0).ipv4_numeric();
+            EthernetFrame frame;
+            frame.header() = {{2, 0, 0, 0, 0, 1}, {2, 0, 0, 0, 0, 2}, EthernetHeader::TYPE_ARP};
+            frame.payload() = arp.serialize();
+            iface.recv_frame(frame);
+            // the mapping should expire after 30 s
+            test_should_be(iface.next_timer(), 30001u);
+
+            TimerWheel wheel;
+            WheelTicker<NetworkInterface> ticker{wheel, iface};
+            wheel.advance(30001);
+            // the wheel should expire the mapping
+            test_should_be(iface.next_timer().has_value(), false);
+            test_should_be(wheel.size(), 0u);
+            iface.send_datagram({}, Address("10.0.0.2", 0));
+            // a forgotten mapping is asked for
+            test_should_be(iface.frames_out().front().header().type, EthernetHeader::TYPE_ARP);
+        }
+
+        {
+            TCPConnection idle{TCPConfig{}};
+            // a connection that hasn't started needs no ticks
+            test_should_be(idle.next_timer().has_value(), false);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}